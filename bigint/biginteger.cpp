@@ -1,565 +1,4459 @@
-#include "biginteger.h"
-#include <iostream>
-#include <vector>
-
-BigInteger::BigInteger() : digits({0}) {}
-
-BigInteger::BigInteger(int x) {
-    isNegative = (x < 0);
-    x = abs(x);
-    while (x != 0) {
-        digits.push_back(x % base);
-        x /= base;
-    }
-    if (digits.empty()) {
-        digits.push_back(0);
-    }
-}
-
-BigInteger::BigInteger(const std::string& s) {
-    int ind = static_cast<int>(s.size() - 1);
-    int flag = static_cast<int>(s.front() == '-');
-    isNegative = (flag != 0);
-    for (; ind >= flag; ind -= len) {
-        int localFlag = 0;
-        if (s.substr(std::max(0, ind - len + 1),
-                     std::min(ind + 1, len) - localFlag)
-                .front() == '-') {
-            localFlag = 1;
-        }
-        digits.push_back(
-            std::stoi(s.substr(std::max(localFlag, ind - len + 1),
-                               std::min(ind + 1, len) - localFlag)));
-    }
-}
-
-const std::vector<long long int>& BigInteger::getDigits() {
-    return digits;
-}
-
-const std::vector<long long int>& BigInteger::getDigits() const {
-    return digits;
-}
-
-bool BigInteger::getNegative() const {
-    return isNegative;
-}
-
-void BigInteger::normalize() {
-    if (digits.empty()) {
-        return;
-    }
-    for (size_t i = 0; i < digits.size() - 1; ++i) {
-        digits[i + 1] += digits[i] / base;
-        digits[i] = (digits[i] + base) % base;
-    }
-    if (digits.back() >= base) {
-        digits.push_back(0);
-        digits.back() += digits[digits.size() - 2] / base;
-        digits[digits.size() - 2] %= base;
-    }
-}
-
-BigInteger& BigInteger::operator+=(const BigInteger& second) {
-    if (isNegative != second.isNegative) {
-        isNegative ^= 1;
-        *this -= second;
-        isNegative ^= 1;
-        return *this;
-    }
-    for (size_t i = 0; i < std::min(digits.size(), second.digits.size()); ++i) {
-        digits[i] += second.digits[i];
-    }
-    for (size_t i = digits.size(); i < second.digits.size(); ++i) {
-        digits.push_back(second.digits[i]);
-    }
-    normalize();
-    return *this;
-}
-
-BigInteger& BigInteger::operator-=(const BigInteger& second) {
-    if (isNegative != second.isNegative) {
-        isNegative ^= 1;
-        *this += second;
-        isNegative ^= 1;
-        return *this;
-    }
-    int len = second.digits.size() - digits.size() + 1;
-    for (int i = 0; i < len; ++i) {
-        digits.push_back(0);
-    }
-    for (size_t i = 0; i < std::max(digits.size() - 1, second.digits.size());
-         ++i) {
-        int val = 0;
-        if (i < second.digits.size()) {
-            val = second.digits[i];
-        }
-        if (digits[i] >= val) {
-            digits[i] -= val;
-            continue;
-        }
-        --digits[i + 1];
-        digits[i] = base + digits[i] - val;
-    }
-    if (digits.back() == -1) {
-        digits = (second - (*this + second)).getDigits();
-        isNegative ^= 1;
-    }
-    while (digits.back() == 0 && digits.size() > 1) {
-        digits.pop_back();
-    }
-    return *this;
-}
-
-BigInteger& BigInteger::operator*=(const BigInteger& second) {
-    BigInteger answer(0);
-    answer.digits.assign(digits.size() + second.digits.size(), 0);
-    for (size_t j = 0; j < second.digits.size(); ++j) {
-        for (size_t i = 0; i < digits.size(); ++i) {
-            answer.digits[i + j] += digits[i] * second.digits[j];
-        }
-        answer.normalize();
-    }
-    while (answer.digits.back() == 0 && answer.digits.size() > 1) {
-        answer.digits.pop_back();
-    }
-    digits = answer.digits;
-    isNegative ^= static_cast<int>(second.isNegative);
-    return *this;
-}
-
-BigInteger& BigInteger::operator>>=(int x) {
-    if (digits.empty()) {
-        digits.push_back(0);
-        return *this;
-    }
-    for (int j = 0; j < x; ++j) {
-        digits.push_back(digits[digits.size() - 1]);
-        for (size_t i = digits.size() - 2; i > 0; --i) {
-            digits[i] = digits[i - 1];
-        }
-        digits[0] = 0;
-    }
-    return *this;
-}
-
-BigInteger& BigInteger::operator/=(const BigInteger& second) {
-    auto sec = second;
-    sec.isNegative = false;
-    isNegative ^= static_cast<int>(second.isNegative);
-    if (*this == 0) {
-        return *this;
-    }
-    BigInteger result, current;
-    result.digits.resize(digits.size());
-    result.isNegative = false;
-    for (long long i = static_cast<long long>(digits.size()) - 1; i >= 0; --i) {
-        current >>= 1;
-        current.digits[0] = digits[i];
-        while (current.digits.back() == 0 && current.digits.size() > 1) {
-            current.digits.pop_back();
-        }
-        int x = 0, l = 0, r = base;
-        while (l <= r) {
-            int m = (l + r) / 2;
-            BigInteger t = sec * m;
-            if (t <= current) {
-                x = m;
-                l = m + 1;
-            } else {
-                r = m - 1;
-            }
-        }
-        result.digits[i] = x;
-        current = current - sec * x;
-    }
-    while (result.digits.back() == 0 && result.digits.size() > 1) {
-        result.digits.pop_back();
-    }
-    digits = result.digits;
-    normalize();
-    return *this;
-}
-
-BigInteger& BigInteger::operator%=(const BigInteger& second) {
-    *this -= (*this / second) * second;
-    return *this;
-}
-
-BigInteger& BigInteger::operator++() {
-    *this += 1;
-    return *this;
-}
-
-BigInteger BigInteger::operator++(int) {
-    auto it(*this);
-    ++(*this);
-    return it;
-}
-
-BigInteger& BigInteger::operator--() {
-    *this -= 1;
-    return *this;
-}
-
-BigInteger BigInteger::operator--(int) {
-    auto it(*this);
-    --(*this);
-    return it;
-}
-
-BigInteger operator+(const BigInteger& first, const BigInteger& second) {
-    BigInteger answer(first);
-    answer += second;
-    return answer;
-}
-
-BigInteger operator-(const BigInteger& first, const BigInteger& second) {
-    BigInteger answer(first);
-    answer -= second;
-    return answer;
-}
-
-BigInteger operator-(const BigInteger& first) {
-    return (0 - first);
-}
-
-BigInteger operator*(BigInteger first, const BigInteger& second) {
-    first *= second;
-    return first;
-}
-
-BigInteger operator/(BigInteger first, const BigInteger& second) {
-    first /= second;
-    return first;
-}
-
-BigInteger operator%(BigInteger first, const BigInteger& second) {
-    return (first %= second);
-}
-
-bool operator==(const BigInteger& first, const BigInteger& second) {
-    return first.getDigits() == second.getDigits();
-}
-
-bool operator!=(const BigInteger& first, const BigInteger& second) {
-    return !(first == second);
-}
-
-bool operator<(const BigInteger& first, const BigInteger& second) {
-    if (first.getNegative() ^ second.getNegative()) {
-        return first.getNegative();
-    }
-    if (first.getDigits().size() != second.getDigits().size() ||
-        first.getDigits().empty()) {
-        return first.getDigits().size() < second.getDigits().size();
-    }
-    int ind = static_cast<int>(first.getDigits().size()) - 1;
-    while (ind >= 0 && first.getDigits()[ind] == second.getDigits()[ind]) {
-        --ind;
-    }
-    return ind > -1 && first.getDigits()[ind] < second.getDigits()[ind] &&
-           (!first.getNegative());
-}
-bool operator>(const BigInteger& first, const BigInteger& second) {
-    return second < first;
-}
-
-bool operator<=(const BigInteger& first, const BigInteger& second) {
-    return !(first > second);
-}
-
-bool operator>=(const BigInteger& first, const BigInteger& second) {
-    return !(first < second);
-}
-
-std::string BigInteger::toString() const {
-    std::string answer;
-    if (isNegative && (*this) != 0) {
-        answer += '-';
-    }
-    answer += std::to_string(digits.back());
-    for (int i = static_cast<int>(digits.size()) - 2; i >= 0; --i) {
-        auto cur = std::to_string(digits[i]);
-        int x = (std::to_string(base).size() - cur.size()) - 1;
-        for (int j = 0; j < x; ++j) {
-            answer += '0';
-        }
-        answer += std::to_string(digits[i]);
-    }
-    return answer;
-}
-
-BigInteger operator""_bi(const char* value, size_t /*unused*/) {
-    BigInteger answer(value);
-    return answer;
-}
-
-BigInteger operator""_bi(unsigned long long value) {
-    BigInteger answer(value);
-    return answer;
-}
-
-std::istream& operator>>(std::istream& is, BigInteger& result) {
-    std::string rawInput;
-    is >> rawInput;
-    result = static_cast<BigInteger>(rawInput);
-    return is;
-}
-
-std::ostream& operator<<(std::ostream& os, const BigInteger& toPrint) {
-    return os << toPrint.toString();
-}
-
-BigInteger::operator bool() {
-    return (*this) != 0;
-}
-
-Rational::Rational() {
-    numerator = 0;
-    denominator = 1;
-}
-
-Rational::Rational(long long first) {
-    numerator = first;
-    denominator = 1;
-    isNegative ^= static_cast<int>(first < 0);
-    if (numerator < 0) {
-        numerator *= -1;
-    }
-}
-
-Rational::Rational(BigInteger first) {
-    numerator = first;
-    denominator = 1;
-    isNegative ^= static_cast<int>(first.getNegative());
-    if (numerator < 0) {
-        numerator *= -1;
-    }
-}
-
-Rational::Rational(BigInteger first, BigInteger second) {
-    numerator = first;
-    denominator = second;
-    gcd(numerator, denominator);
-}
-
-void gcd(BigInteger& first, BigInteger& second) {
-    auto saveFirst = first, saveSecond = second;
-    while (second != 0) {
-        first %= second;
-        std::swap(first, second);
-    }
-    saveFirst /= first;
-    saveSecond /= first;
-    first = saveFirst;
-    second = saveSecond;
-}
-
-const BigInteger& Rational::getDenominator() const {
-    return denominator;
-}
-
-const BigInteger& Rational::getNumerator() const {
-    return numerator;
-}
-
-Rational& Rational::operator+=(const Rational& second) {
-    if (isNegative != second.isNegative) {
-        isNegative ^= 1;
-        *this -= second;
-        isNegative ^= 1;
-        return *this;
-    }
-    numerator = numerator * second.denominator + second.numerator * denominator;
-    denominator *= second.denominator;
-    isNegative = ((isNegative ^ (numerator < 0) ^
-                   static_cast<int>(denominator < 0)) != 0);
-    if (numerator < 0) {
-        numerator *= -1;
-    }
-    if (denominator < 0) {
-        denominator *= -1;
-    }
-    gcd(denominator, numerator);
-    return *this;
-}
-
-Rational& Rational::operator-=(const Rational& second) {
-    if (isNegative != second.isNegative) {
-        isNegative ^= 1;
-        *this += second;
-        isNegative ^= 1;
-        return *this;
-    }
-    numerator = numerator * second.denominator - second.numerator * denominator;
-    denominator *= second.denominator;
-    isNegative = ((isNegative ^ (numerator < 0) ^
-                   static_cast<int>(denominator < 0)) != 0);
-    if (numerator < 0) {
-        numerator *= -1;
-    }
-    if (denominator < 0) {
-        denominator *= -1;
-    }
-    gcd(denominator, numerator);
-    return *this;
-}
-
-Rational& Rational::operator*=(const Rational& second) {
-    numerator *= second.numerator;
-    denominator *= second.denominator;
-    isNegative ^= static_cast<int>(second.isNegative);
-    gcd(denominator, numerator);
-    return *this;
-}
-
-Rational& Rational::operator/=(const Rational& second) {
-    numerator *= second.denominator;
-    denominator *= second.numerator;
-    isNegative ^= static_cast<int>(second.isNegative);
-    gcd(denominator, numerator);
-    return *this;
-}
-
-Rational& Rational::operator++() {
-    numerator += denominator;
-    gcd(denominator, numerator);
-    return *this;
-}
-
-Rational Rational::operator++(int) {
-    auto it(*this);
-    ++(*this);
-    return it;
-}
-
-Rational& Rational::operator--() {
-    numerator -= denominator;
-    isNegative ^= static_cast<int>(denominator.getNegative());
-    if (denominator.getNegative()) {
-        denominator *= -1;
-    }
-    gcd(denominator, numerator);
-    return *this;
-}
-
-Rational Rational::operator--(int) {
-    auto it(*this);
-    --(*this);
-    return it;
-}
-
-Rational operator+(const Rational& first, const Rational& second) {
-    Rational answer(first);
-    answer += second;
-    return answer;
-}
-
-Rational operator-(const Rational& first, const Rational& second) {
-    Rational answer(first);
-    answer -= second;
-    return answer;
-}
-
-Rational operator-(const Rational& first) {
-    return (0 - first);
-}
-
-Rational operator*(Rational first, const Rational& second) {
-    first *= second;
-    return first;
-}
-
-Rational operator/(Rational first, const Rational& second) {
-    first /= second;
-    return first;
-}
-
-bool operator==(const Rational& first, const Rational& second) {
-    return first.getNumerator() == second.getNumerator() &&
-           first.getDenominator() == second.getDenominator();
-}
-
-bool operator!=(const Rational& first, const Rational& second) {
-    return !(first == second);
-}
-
-bool operator<(const Rational& first, const Rational& second) {
-    int firstSign = 1, secondSign = 1;
-    if (first.getSign()) {
-        firstSign = -1;
-    }
-    if (second.getSign()) {
-        secondSign = -1;
-    }
-    return (firstSign * first.getNumerator() * second.getDenominator() -
-                secondSign * second.getNumerator() * first.getDenominator() <
-            0);
-}
-
-bool operator<=(const Rational& first, const Rational& second) {
-    return !(first > second);
-}
-
-bool operator>(const Rational& first, const Rational& second) {
-    return second < first;
-}
-
-bool operator>=(const Rational& first, const Rational& second) {
-    return !(first < second);
-}
-
-std::string Rational::toString() const {
-    std::string answer;
-    if (isNegative) {
-        answer += '-';
-    }
-    answer += numerator.toString();
-    if (denominator == 1 || numerator == 0) {
-        return answer;
-    }
-    answer += '/' + denominator.toString();
-    return answer;
-}
-
-long long BigInteger::getBase() const {
-    return base;
-}
-
-std::string Rational::asDecimal(size_t precision) {
-    std::string answer;
-    if (isNegative) {
-        answer += '-';
-    }
-    auto doub = (numerator / denominator).toString();
-    std::string cntZero;
-    auto save = numerator;
-    while (numerator < denominator) {
-        numerator *= 10;
-        cntZero += '0';
-    }
-    if (!cntZero.empty()) {
-        cntZero.pop_back();
-    }
-    numerator = save;
-    for (size_t i = 0; i < std::max(static_cast<size_t>(3), precision / 5);
-         ++i) {
-        numerator *= numerator.getBase();
-    }
-    auto cur = (numerator / denominator).toString();
-    numerator = save;
-    answer += doub + '.' + cntZero +
-              cur.substr(
-                  doub.size() - 1 + static_cast<unsigned long>(doub != "0"),
-                  std::max(static_cast<size_t>(0), precision - cntZero.size()));
-    return answer;
-}
-
-Rational::operator double() {
-    return static_cast<double>(std::stod((*this).asDecimal(30)));
-}
-
-bool Rational::getSign() const {
-    return isNegative;
-}
+#include "biginteger.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Products whose shorter operand has at least this many limbs use
+// Karatsuba multiplication.
+constexpr size_t kKaratsubaThreshold = 32;
+
+// Squares of at least this many limbs use Karatsuba squaring; the squaring
+// basecase does half the limb products, so it stays ahead for longer.
+constexpr size_t kKaratsubaSquareThreshold = 48;
+
+// Products whose shorter operand has at least this many limbs are split
+// across threads unless setParallelMultiplicationThreshold says otherwise.
+constexpr size_t kParallelMultiplicationThreshold = 1024;
+
+// Loops over matrix rows or primality candidates whose estimated work, in
+// limb products, reaches this are split across threads.
+constexpr size_t kParallelLoopWork = 4096;
+
+// isProbablePrime divides by the primes below this before any powering.
+constexpr uint32_t kTrialDivisionBound = 1024;
+
+// primesInRange sieves by the primes below this, segment by segment.
+constexpr uint32_t kSieveBound = 1U << 16;
+constexpr size_t kSieveSegment = 1U << 15;
+
+// Quotient chunks of at least this many limbs use Burnikel-Ziegler
+// division; shorter ones use Knuth's algorithm D.
+constexpr size_t kRecursiveDivisionThreshold = 60;
+
+// Lehmer's gcd keeps the cofactors of its single-precision simulation below
+// this bound so that they fit in one limb.
+constexpr int64_t kCofactorLimit = 0xFFFFFFFF;
+
+// Decimal conversion works in chunks of kDecimalChunkDigits digits.
+constexpr uint32_t kDecimalChunk = 1'000'000'000;
+constexpr size_t kDecimalChunkDigits = 9;
+
+// Decimal conversion of values longer than this many limbs (or digit strings
+// longer than this many chunks) splits by powers of 10^9 recursively.
+constexpr size_t kDecimalConversionThreshold = 40;
+
+// operator>> holds at most 9 * 2^kStreamBlockLevel digits of text at once.
+constexpr size_t kStreamBlockLevel = 10;
+
+// Scratch limbs are taken from blocks of at least this many limbs.
+constexpr size_t kScratchBlock = 4096;
+
+constexpr int kLimbBits = 32;
+constexpr uint64_t kLimbBase = uint64_t{1} << kLimbBits;
+
+// The allocator installed by setLimbAllocator.
+LimbAllocator& limbAllocator() {
+    static LimbAllocator allocator = {
+        [](size_t size) { return new uint32_t[size]; },
+        [](uint32_t* limbs, size_t /*size*/) { delete[] limbs; }};
+    return allocator;
+}
+
+void trim(LimbVector& digits) {
+    while (digits.back() == 0 && digits.size() > 1) {
+        digits.pop_back();
+    }
+}
+
+int compareAbs(const LimbVector& first, const LimbVector& second) {
+    if (first.size() != second.size()) {
+        return first.size() < second.size() ? -1 : 1;
+    }
+    for (size_t i = first.size(); i-- > 0;) {
+        if (first[i] != second[i]) {
+            return first[i] < second[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+// first += second
+void addAbs(LimbVector& first, const LimbVector& second) {
+    if (first.size() < second.size()) {
+        first.resize(second.size(), 0);
+    }
+    uint64_t carry = 0;
+    size_t i = 0;
+    for (; i < second.size(); ++i) {
+        carry += static_cast<uint64_t>(first[i]) + second[i];
+        first[i] = static_cast<uint32_t>(carry);
+        carry >>= kLimbBits;
+    }
+    for (; carry != 0 && i < first.size(); ++i) {
+        carry += first[i];
+        first[i] = static_cast<uint32_t>(carry);
+        carry >>= kLimbBits;
+    }
+    if (carry != 0) {
+        first.push_back(static_cast<uint32_t>(carry));
+    }
+}
+
+// first -= second, requires |first| >= |second|
+void subAbs(LimbVector& first, const LimbVector& second) {
+    uint64_t borrow = 0;
+    size_t i = 0;
+    for (; i < second.size(); ++i) {
+        uint64_t cur = static_cast<uint64_t>(first[i]) - second[i] - borrow;
+        first[i] = static_cast<uint32_t>(cur);
+        borrow = cur >> (2 * kLimbBits - 1);
+    }
+    for (; borrow != 0 && i < first.size(); ++i) {
+        uint64_t cur = static_cast<uint64_t>(first[i]) - borrow;
+        first[i] = static_cast<uint32_t>(cur);
+        borrow = cur >> (2 * kLimbBits - 1);
+    }
+    trim(first);
+}
+
+// first = second - first, requires |second| >= |first|
+void subAbsReversed(LimbVector& first, const LimbVector& second) {
+    first.resize(second.size(), 0);
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < second.size(); ++i) {
+        uint64_t cur = static_cast<uint64_t>(second[i]) - first[i] - borrow;
+        first[i] = static_cast<uint32_t>(cur);
+        borrow = cur >> (2 * kLimbBits - 1);
+    }
+    trim(first);
+}
+
+// dst[0, dstSize) += src[0, srcSize), returns the carry out of dst
+uint32_t addTo(uint32_t* dst, size_t dstSize, const uint32_t* src,
+               size_t srcSize) {
+    uint64_t carry = 0;
+    size_t i = 0;
+    for (; i < srcSize; ++i) {
+        carry += static_cast<uint64_t>(dst[i]) + src[i];
+        dst[i] = static_cast<uint32_t>(carry);
+        carry >>= kLimbBits;
+    }
+    for (; carry != 0 && i < dstSize; ++i) {
+        carry += dst[i];
+        dst[i] = static_cast<uint32_t>(carry);
+        carry >>= kLimbBits;
+    }
+    return static_cast<uint32_t>(carry);
+}
+
+// dst[0, dstSize) -= src[0, srcSize), returns the borrow out of dst
+uint32_t subFrom(uint32_t* dst, size_t dstSize, const uint32_t* src,
+                 size_t srcSize) {
+    uint64_t borrow = 0;
+    size_t i = 0;
+    for (; i < srcSize; ++i) {
+        uint64_t cur = static_cast<uint64_t>(dst[i]) - src[i] - borrow;
+        dst[i] = static_cast<uint32_t>(cur);
+        borrow = cur >> (2 * kLimbBits - 1);
+    }
+    for (; borrow != 0 && i < dstSize; ++i) {
+        uint64_t cur = static_cast<uint64_t>(dst[i]) - borrow;
+        dst[i] = static_cast<uint32_t>(cur);
+        borrow = cur >> (2 * kLimbBits - 1);
+    }
+    return static_cast<uint32_t>(borrow);
+}
+
+// A per-thread stack of limbs for the temporaries of the arithmetic
+// kernels. Blocks are kept for the life of the thread, so once the largest
+// operation has run its scratch needs no allocation at all.
+class ScratchArena {
+  public:
+    struct Mark {
+        size_t block;
+        size_t used;
+    };
+
+    static ScratchArena& local() {
+        thread_local ScratchArena arena;
+        return arena;
+    }
+
+    // size limbs at the top of the stack; mark is what release restores.
+    uint32_t* take(size_t size, Mark& mark) {
+        mark = {current, used};
+        while (current < blocks.size() && used + size > blocks[current].size) {
+            ++current;
+            used = 0;
+        }
+        if (current == blocks.size()) {
+            size_t blockSize = std::max(
+                size, blocks.empty() ? kScratchBlock : 2 * blocks.back().size);
+            blocks.push_back(
+                {std::make_unique_for_overwrite<uint32_t[]>(blockSize),
+                 blockSize});
+        }
+        uint32_t* limbs = blocks[current].limbs.get() + used;
+        used += size;
+        return limbs;
+    }
+
+    void release(const Mark& mark) {
+        current = mark.block;
+        used = mark.used;
+    }
+
+  private:
+    struct Block {
+        std::unique_ptr<uint32_t[]> limbs;
+        size_t size;
+    };
+
+    std::vector<Block> blocks;
+    size_t current = 0;
+    size_t used = 0;
+};
+
+// size uninitialized limbs from the calling thread's arena, given back when
+// the buffer goes out of scope. Scoping keeps the releases in stack order.
+class ScratchBuffer {
+  public:
+    explicit ScratchBuffer(size_t size)
+        : limbs(ScratchArena::local().take(size, mark)), count(size) {
+    }
+
+    ScratchBuffer(const ScratchBuffer&) = delete;
+    ScratchBuffer& operator=(const ScratchBuffer&) = delete;
+
+    ~ScratchBuffer() {
+        ScratchArena::local().release(mark);
+    }
+
+    uint32_t* data() {
+        return limbs;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    uint32_t& operator[](size_t index) {
+        return limbs[index];
+    }
+
+  private:
+    ScratchArena::Mark mark{};
+    uint32_t* limbs;
+    size_t count;
+};
+
+// out[0, n + m) = a[0, n) * b[0, m)
+void mulBasecase(const uint32_t* a, size_t n, const uint32_t* b, size_t m,
+                 uint32_t* out) {
+    std::fill(out, out + n + m, 0);
+    for (size_t j = 0; j < m; ++j) {
+        if (b[j] == 0) {
+            continue;
+        }
+        uint64_t carry = 0;
+        for (size_t i = 0; i < n; ++i) {
+            carry += static_cast<uint64_t>(a[i]) * b[j] + out[i + j];
+            out[i + j] = static_cast<uint32_t>(carry);
+            carry >>= kLimbBits;
+        }
+        out[j + n] = static_cast<uint32_t>(carry);
+    }
+}
+
+// sum[0, half] = a[0, half) + a[half, n), for n >= half
+void halfSum(const uint32_t* a, size_t n, size_t half, uint32_t* sum) {
+    std::copy(a, a + half, sum);
+    sum[half] = addTo(sum, half, a + half, n - half);
+}
+
+// Adds the Karatsuba middle product (a0 + a1)(b0 + b1), less the low and
+// high products already in out[0, size), at out + half.
+void addMiddle(uint32_t* out, size_t size, size_t half,
+               ScratchBuffer& middle) {
+    subFrom(middle.data(), middle.size(), out, 2 * half);
+    subFrom(middle.data(), middle.size(), out + 2 * half, size - 2 * half);
+    addTo(out + half, size - half, middle.data(),
+          std::min(middle.size(), size - half));
+}
+
+// out[0, 2n) = a[0, n)^2. Each cross product a_i a_j with i < j is computed
+// once; their sum is doubled and the squares a_i^2 added in one pass.
+void sqrBasecase(const uint32_t* a, size_t n, uint32_t* out) {
+    std::fill(out, out + 2 * n, 0);
+    for (size_t i = 0; i + 1 < n; ++i) {
+        uint64_t factor = a[i];
+        if (factor == 0) {
+            continue;
+        }
+        uint64_t carry = 0;
+        for (size_t j = i + 1; j < n; ++j) {
+            carry += factor * a[j] + out[i + j];
+            out[i + j] = static_cast<uint32_t>(carry);
+            carry >>= kLimbBits;
+        }
+        out[i + n] = static_cast<uint32_t>(carry);
+    }
+    uint64_t carry = 0;
+    uint32_t shifted = 0;
+    for (size_t i = 0; i < 2 * n; ++i) {
+        uint64_t square = static_cast<uint64_t>(a[i / 2]) * a[i / 2];
+        uint32_t part = static_cast<uint32_t>(square >> (i % 2 * kLimbBits));
+        carry += static_cast<uint64_t>((out[i] << 1) | shifted) + part;
+        shifted = out[i] >> (kLimbBits - 1);
+        out[i] = static_cast<uint32_t>(carry);
+        carry >>= kLimbBits;
+    }
+}
+
+// out[0, 2n) = a[0, n)^2 with the three half-size products of Karatsuba
+// all squares: a0^2, a1^2 and (a0 + a1)^2.
+void sqrKaratsuba(const uint32_t* a, size_t n, uint32_t* out) {
+    if (n < kKaratsubaSquareThreshold) {
+        sqrBasecase(a, n, out);
+        return;
+    }
+    size_t half = (n + 1) / 2;
+    sqrKaratsuba(a, half, out);
+    sqrKaratsuba(a + half, n - half, out + 2 * half);
+    ScratchBuffer sum(half + 1);
+    halfSum(a, n, half, sum.data());
+    ScratchBuffer middle(2 * half + 2);
+    sqrKaratsuba(sum.data(), half + 1, middle.data());
+    addMiddle(out, 2 * n, half, middle);
+}
+
+// out[0, n + m) = a[0, n) * b[0, m). Operands are split at half of the
+// longer one: (a1 x + a0)(b1 x + b0) costs three half-size products, since
+// a1 b0 + a0 b1 = (a0 + a1)(b0 + b1) - a0 b0 - a1 b1. An operand shorter
+// than half of the other is multiplied by the longer one slice by slice.
+void mulKaratsuba(const uint32_t* a, size_t n, const uint32_t* b, size_t m,
+                  uint32_t* out) {
+    if (a == b && n == m) {
+        sqrKaratsuba(a, n, out);
+        return;
+    }
+    if (n < m) {
+        std::swap(a, b);
+        std::swap(n, m);
+    }
+    if (m < kKaratsubaThreshold) {
+        mulBasecase(a, n, b, m, out);
+        return;
+    }
+    size_t half = (n + 1) / 2;
+    if (m <= half) {
+        std::fill(out, out + n + m, 0);
+        ScratchBuffer part(2 * m);
+        for (size_t i = 0; i < n; i += m) {
+            size_t size = std::min(m, n - i);
+            mulKaratsuba(a + i, size, b, m, part.data());
+            addTo(out + i, n + m - i, part.data(), size + m);
+        }
+        return;
+    }
+    mulKaratsuba(a, half, b, half, out);
+    mulKaratsuba(a + half, n - half, b + half, m - half, out + 2 * half);
+    ScratchBuffer firstSum(half + 1);
+    halfSum(a, n, half, firstSum.data());
+    ScratchBuffer secondSum(half + 1);
+    halfSum(b, m, half, secondSum.data());
+    ScratchBuffer middle(2 * half + 2);
+    mulKaratsuba(firstSum.data(), half + 1, secondSum.data(), half + 1,
+                 middle.data());
+    addMiddle(out, n + m, half, middle);
+}
+
+// A fixed set of threads running submitted tasks in FIFO order.
+class WorkerPool {
+  public:
+    explicit WorkerPool(unsigned workers) {
+        for (unsigned i = 0; i < workers; ++i) {
+            threads.emplace_back([this] { work(); });
+        }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        ready.notify_all();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    // Queues task on behalf of owner, which runPending matches against.
+    void submit(const void* owner, std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back({owner, std::move(task)});
+        }
+        ready.notify_one();
+    }
+
+    // Runs the oldest queued task of owner in the calling thread, false if
+    // there was none. Tasks of other owners are left to the workers: the
+    // caller may be in the middle of a computation that such a task would
+    // re-enter.
+    bool runPending(const void* owner) {
+        std::function<void()> task;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto found = std::find_if(
+                tasks.begin(), tasks.end(),
+                [owner](const Task& queued) { return queued.owner == owner; });
+            if (found == tasks.end()) {
+                return false;
+            }
+            task = std::move(found->run);
+            tasks.erase(found);
+        }
+        task();
+        return true;
+    }
+
+  private:
+    struct Task {
+        const void* owner;
+        std::function<void()> run;
+    };
+
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<Task> tasks;
+    bool stopping = false;
+    std::vector<std::thread> threads;
+
+    void work() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (tasks.empty()) {
+                    return;
+                }
+                task = std::move(tasks.front().run);
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+};
+
+// Fork-join over a WorkerPool. wait() runs the group's own queued tasks,
+// so a task may itself fork and wait without tying up a worker, then
+// sleeps until the ones taken by workers have finished. It never picks up
+// another group's task, which could re-enter whatever the waiting thread
+// is in the middle of. Only the thread that waits adds tasks.
+class TaskGroup {
+  public:
+    explicit TaskGroup(WorkerPool& pool) : pool(pool) {}
+
+    template <typename Task>
+    void run(Task task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++pending;
+        }
+        pool.submit(this, [this, task = std::move(task)] {
+            task();
+            // Notified under the lock: wait() cannot return, and the group
+            // go away, before the notification is done.
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending == 0) {
+                finished.notify_one();
+            }
+        });
+    }
+
+    void wait() {
+        while (pool.runPending(this)) {
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this] { return pending == 0; });
+    }
+
+  private:
+    WorkerPool& pool;
+    std::mutex mutex;
+    std::condition_variable finished;
+    size_t pending = 0;
+};
+
+struct ParallelSettings {
+    std::mutex mutex;
+    unsigned threads = std::max(1U, std::thread::hardware_concurrency());
+    std::atomic<size_t> threshold = kParallelMultiplicationThreshold;
+    // Created on first use with threads - 1 workers, the calling thread
+    // being the last one; dropped when the thread count changes.
+    std::shared_ptr<WorkerPool> pool;
+};
+
+ParallelSettings& parallelSettings() {
+    static ParallelSettings settings;
+    return settings;
+}
+
+// The pool for the configured thread count, created on first use; null
+// when a single thread is configured.
+std::shared_ptr<WorkerPool> sharedPool(unsigned& threads) {
+    ParallelSettings& settings = parallelSettings();
+    std::lock_guard<std::mutex> lock(settings.mutex);
+    threads = settings.threads;
+    if (threads <= 1) {
+        return nullptr;
+    }
+    if (settings.pool == nullptr) {
+        settings.pool = std::make_shared<WorkerPool>(threads - 1);
+    }
+    return settings.pool;
+}
+
+// mulKaratsuba with the subproducts of the top levels run as pool tasks,
+// the calling thread computing one of them itself. Each level hands a
+// third of the task budget to every subproduct; once the budget is spent
+// or the operands fall below threshold the recursion is serial. threshold
+// is at least kKaratsubaThreshold, so every split shrinks the operands.
+void mulParallel(const uint32_t* a, size_t n, const uint32_t* b, size_t m,
+                 uint32_t* out, WorkerPool& pool, size_t threshold,
+                 unsigned budget) {
+    if (n < m) {
+        std::swap(a, b);
+        std::swap(n, m);
+    }
+    if (budget <= 1 || m < threshold) {
+        mulKaratsuba(a, n, b, m, out);
+        return;
+    }
+    size_t half = (n + 1) / 2;
+    TaskGroup group(pool);
+    if (m <= half) {
+        size_t slices = (n + m - 1) / m;
+        unsigned share = static_cast<unsigned>((budget + slices - 1) / slices);
+        ScratchBuffer parts(slices * 2 * m);
+        for (size_t i = 0; i < n; i += m) {
+            uint32_t* part = parts.data() + i / m * 2 * m;
+            group.run([=, &pool] {
+                mulParallel(a + i, std::min(m, n - i), b, m, part, pool,
+                            threshold, share);
+            });
+        }
+        group.wait();
+        std::fill(out, out + n + m, 0);
+        for (size_t i = 0; i < n; i += m) {
+            addTo(out + i, n + m - i, parts.data() + i / m * 2 * m,
+                  std::min(m, n - i) + m);
+        }
+        return;
+    }
+    unsigned share = (budget + 2) / 3;
+    group.run([=, &pool] {
+        mulParallel(a, half, b, half, out, pool, threshold, share);
+    });
+    group.run([=, &pool] {
+        mulParallel(a + half, n - half, b + half, m - half, out + 2 * half,
+                    pool, threshold, share);
+    });
+    // For a square the middle product stays a square.
+    bool square = a == b && n == m;
+    ScratchBuffer firstSum(half + 1);
+    halfSum(a, n, half, firstSum.data());
+    ScratchBuffer secondSum(square ? 0 : half + 1);
+    if (!square) {
+        halfSum(b, m, half, secondSum.data());
+    }
+    const uint32_t* second = square ? firstSum.data() : secondSum.data();
+    ScratchBuffer middle(2 * half + 2);
+    mulParallel(firstSum.data(), half + 1, second, half + 1, middle.data(),
+                pool, threshold, share);
+    group.wait();
+    addMiddle(out, n + m, half, middle);
+}
+
+// out[0, n + m) = a[0, n) * b[0, m), in parallel for large enough operands
+void mulLimbs(const uint32_t* a, size_t n, const uint32_t* b, size_t m,
+              uint32_t* out) {
+    ParallelSettings& settings = parallelSettings();
+    size_t threshold = settings.threshold.load(std::memory_order_relaxed);
+    if (std::min(n, m) < threshold) {
+        mulKaratsuba(a, n, b, m, out);
+        return;
+    }
+    unsigned threads = 0;
+    std::shared_ptr<WorkerPool> pool = sharedPool(threads);
+    if (pool == nullptr) {
+        mulKaratsuba(a, n, b, m, out);
+        return;
+    }
+    mulParallel(a, n, b, m, out, *pool, threshold, 2 * threads);
+}
+
+// Products are built in a per-thread spare buffer, and the limbs they
+// replace become the next spare, so repeated products reuse two buffers.
+// The spare is taken out for the duration of the product: a product run
+// meanwhile on the same thread, from a pool task, finds it empty and
+// allocates instead of writing into a buffer in use.
+LimbVector& spareLimbs() {
+    thread_local LimbVector spare;
+    return spare;
+}
+
+LimbVector takeSpareLimbs() {
+    return std::move(spareLimbs());
+}
+
+void keepSpareLimbs(LimbVector limbs) {
+    if (limbs.capacity() > spareLimbs().capacity()) {
+        spareLimbs() = std::move(limbs);
+    }
+}
+
+// answer = first * second, answer must not alias either operand
+void mulAbs(const LimbVector& first, const LimbVector& second,
+            LimbVector& answer) {
+    answer.resize(first.size() + second.size());
+    mulLimbs(first.data(), first.size(), second.data(), second.size(),
+             answer.data());
+    trim(answer);
+}
+
+// Compares a[0, size) with b[0, size).
+int compareLimbs(const uint32_t* a, const uint32_t* b, size_t size) {
+    for (size_t i = size; i-- > 0;) {
+        if (a[i] != b[i]) {
+            return a[i] < b[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+// out[0, size) = a[0, size) << shift for shift < 32, returns the bits
+// shifted out at the top.
+uint32_t shiftLimbsLeft(const uint32_t* a, size_t size, int shift,
+                        uint32_t* out) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < size; ++i) {
+        carry |= static_cast<uint64_t>(a[i]) << shift;
+        out[i] = static_cast<uint32_t>(carry);
+        carry >>= kLimbBits;
+    }
+    return static_cast<uint32_t>(carry);
+}
+
+// out[0, size) = a[0, size) >> shift for shift < 32
+void shiftLimbsRight(const uint32_t* a, size_t size, int shift,
+                     uint32_t* out) {
+    for (size_t i = 0; i < size; ++i) {
+        uint64_t next = i + 1 < size ? a[i + 1] : 0;
+        out[i] = static_cast<uint32_t>(((next << kLimbBits) | a[i]) >> shift);
+    }
+}
+
+// Knuth, TAOCP vol. 2, 4.3.1, Algorithm D on u[0, size) and v[0, n), where
+// n >= 2 and the top bit of v is set. The low size - n limbs of the
+// quotient go to q and its top limb, 0 or 1, is returned; the remainder is
+// left in u[0, n).
+uint32_t divBasecase(uint32_t* q, uint32_t* u, size_t size, const uint32_t* v,
+                     size_t n) {
+    uint32_t high = 0;
+    if (compareLimbs(u + size - n, v, n) >= 0) {
+        subFrom(u + size - n, n, v, n);
+        high = 1;
+    }
+    for (size_t j = size - n; j-- > 0;) {
+        uint64_t top = (static_cast<uint64_t>(u[j + n]) << kLimbBits) |
+                       u[j + n - 1];
+        uint64_t qhat = top / v[n - 1];
+        uint64_t rhat = top % v[n - 1];
+        while (qhat >= kLimbBase ||
+               qhat * v[n - 2] > ((rhat << kLimbBits) | u[j + n - 2])) {
+            --qhat;
+            rhat += v[n - 1];
+            if (rhat >= kLimbBase) {
+                break;
+            }
+        }
+        uint64_t borrow = 0;
+        uint64_t carry = 0;
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t product = qhat * v[i] + carry;
+            carry = product >> kLimbBits;
+            uint64_t cur = static_cast<uint64_t>(u[i + j]) -
+                           static_cast<uint32_t>(product) - borrow;
+            u[i + j] = static_cast<uint32_t>(cur);
+            borrow = cur >> (2 * kLimbBits - 1);
+        }
+        uint64_t cur = static_cast<uint64_t>(u[j + n]) - carry - borrow;
+        u[j + n] = static_cast<uint32_t>(cur);
+        if ((cur >> (2 * kLimbBits - 1)) != 0) {
+            --qhat;
+            u[j + n] += addTo(u + j, n, v, n);
+        }
+        q[j] = static_cast<uint32_t>(qhat);
+    }
+    return high;
+}
+
+uint32_t divRecursive(uint32_t* q, uint32_t* u, const uint32_t* v, size_t n,
+                      uint32_t* scratch);
+
+// Divides u[0, n + k) by the normalized v[0, n) for k <= n, the top n limbs
+// of u being less than v. The low k limbs of the quotient go to q and its
+// top limb, 0 or 1, is returned; the remainder is left in u[0, n) and
+// scratch holds n limbs. For large k the quotient is first estimated from
+// the top 2k limbs of u and the top k limbs of v, which is at most two too
+// large, and then corrected by subtracting its product with the rest of v.
+uint32_t divChunk(uint32_t* q, uint32_t* u, size_t k, const uint32_t* v,
+                  size_t n, uint32_t* scratch) {
+    if (k < kRecursiveDivisionThreshold) {
+        return divBasecase(q, u, n + k, v, n);
+    }
+    uint32_t top = divRecursive(q, u + n - k, v + n - k, k, scratch);
+    if (k == n) {
+        return top;
+    }
+    // Zero limbs at either end of the rest of v, as in 2^x + c or in the
+    // powers of ten of decimal conversion, are left out of the product.
+    const uint32_t one = 1;
+    size_t from = 0;
+    size_t to = n - k;
+    while (from < to && v[from] == 0) {
+        ++from;
+    }
+    while (from < to && v[to - 1] == 0) {
+        --to;
+    }
+    uint32_t borrow = 0;
+    if (from < to) {
+        mulLimbs(q, k, v + from, to - from, scratch);
+        borrow = subFrom(u + from, n - from, scratch, k + to - from);
+    }
+    if (top != 0) {
+        borrow += subFrom(u + k, n - k, v, n - k);
+    }
+    while (borrow != 0) {
+        top -= subFrom(q, k, &one, 1);
+        borrow -= addTo(u, n, v, n);
+    }
+    return top;
+}
+
+// Burnikel, Ziegler, "Fast Recursive Division" (1998): u[0, 2n) divided by
+// the normalized v[0, n) as two chunks of about n / 2 quotient limbs each.
+uint32_t divRecursive(uint32_t* q, uint32_t* u, const uint32_t* v, size_t n,
+                      uint32_t* scratch) {
+    if (n < kRecursiveDivisionThreshold) {
+        return divBasecase(q, u, 2 * n, v, n);
+    }
+    size_t low = n / 2;
+    uint32_t top = divChunk(q + low, u + low, n - low, v, n, scratch);
+    divChunk(q, u, low, v, n, scratch);
+    return top;
+}
+
+// columns[i] += limbs[i] for i < size, each limb widened to 64 bits. With
+// AVX2 four limbs are widened and added per instruction.
+void addColumns(uint64_t* columns, const uint32_t* limbs, size_t size) {
+    size_t i = 0;
+#ifdef __AVX2__
+    for (; i + 4 <= size; i += 4) {
+        __m256i sum = _mm256_add_epi64(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(columns + i)),
+            _mm256_cvtepu32_epi64(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(limbs + i))));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(columns + i), sum);
+    }
+#endif
+    for (; i < size; ++i) {
+        columns[i] += limbs[i];
+    }
+}
+
+// The splitmix64 finalizer: every input bit affects every output bit.
+uint64_t mixBits(uint64_t value) {
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EB;
+    return value ^ (value >> 31);
+}
+
+// Folds the limbs into seed 64 bits at a time with a multiply and
+// xor-shift per word, then finalizes.
+uint64_t hashLimbs(const LimbVector& digits, uint64_t seed) {
+    constexpr uint64_t kMultiplier = 0x9E3779B97F4A7C15;
+    uint64_t hash = seed ^ (digits.size() * kMultiplier);
+    size_t i = 0;
+    for (; i + 1 < digits.size(); i += 2) {
+        uint64_t word = digits[i] | (static_cast<uint64_t>(digits[i + 1])
+                                     << kLimbBits);
+        hash = (hash ^ word) * kMultiplier;
+        hash ^= hash >> 29;
+    }
+    if (i < digits.size()) {
+        hash = (hash ^ digits[i]) * kMultiplier;
+        hash ^= hash >> 29;
+    }
+    return mixBits(hash);
+}
+
+constexpr size_t kLimbBytes = sizeof(uint32_t);
+
+size_t varintSize(uint64_t value) {
+    return (std::max<size_t>(std::bit_width(value), 1) + 6) / 7;
+}
+
+void writeVarint(uint64_t value, uint8_t* out) {
+    for (; value >= 0x80; value >>= 7) {
+        *out++ = static_cast<uint8_t>(value | 0x80);
+    }
+    *out = static_cast<uint8_t>(value);
+}
+
+// Reads a varint of at most 63 bits from the front of in; returns its size,
+// or 0 when in ends inside it or it is too long.
+size_t readVarint(std::span<const uint8_t> in, uint64_t& value) {
+    value = 0;
+    for (size_t i = 0; i < in.size() && i < 9; ++i) {
+        value |= static_cast<uint64_t>(in[i] & 0x7F) << (7 * i);
+        if ((in[i] & 0x80) == 0) {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+void storeLimbs(const uint32_t* limbs, size_t count, uint8_t* out) {
+    if constexpr (std::endian::native == std::endian::little) {
+        std::memcpy(out, limbs, count * kLimbBytes);
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            for (size_t j = 0; j < kLimbBytes; ++j) {
+                out[i * kLimbBytes + j] =
+                    static_cast<uint8_t>(limbs[i] >> (8 * j));
+            }
+        }
+    }
+}
+
+uint32_t loadLimb(const uint8_t* in) {
+    uint32_t limb = 0;
+    if constexpr (std::endian::native == std::endian::little) {
+        std::memcpy(&limb, in, kLimbBytes);
+    } else {
+        for (size_t j = 0; j < kLimbBytes; ++j) {
+            limb |= static_cast<uint32_t>(in[j]) << (8 * j);
+        }
+    }
+    return limb;
+}
+
+// The value of the 8 decimal digits at s. On little-endian targets they are
+// loaded as one word and combined pairwise, four digit pairs, then two
+// 4-digit halves, each round a multiply and a shift (SWAR).
+uint32_t parseEightDigits(const char* s) {
+    if constexpr (std::endian::native == std::endian::little) {
+        uint64_t chunk = 0;
+        std::memcpy(&chunk, s, sizeof(chunk));
+        chunk -= 0x3030303030303030;
+        chunk = (chunk * 10 + (chunk >> 8)) & 0x00FF00FF00FF00FF;
+        chunk = (chunk * 100 + (chunk >> 16)) & 0x0000FFFF0000FFFF;
+        return static_cast<uint32_t>(chunk * 10000 + (chunk >> 32));
+    } else {
+        uint32_t value = 0;
+        for (size_t i = 0; i < 8; ++i) {
+            value = value * 10 + static_cast<uint32_t>(s[i] - '0');
+        }
+        return value;
+    }
+}
+
+// digits = digits * factor + addend
+void mulAddSmall(LimbVector& digits, uint32_t factor, uint32_t addend) {
+    uint64_t carry = addend;
+    for (uint32_t& digit : digits) {
+        carry += static_cast<uint64_t>(digit) * factor;
+        digit = static_cast<uint32_t>(carry);
+        carry >>= kLimbBits;
+    }
+    if (carry != 0) {
+        digits.push_back(static_cast<uint32_t>(carry));
+    }
+    trim(digits);
+}
+
+// limbs[0, size) /= divisor, returns the remainder
+uint32_t divSmall(uint32_t* limbs, size_t size, uint32_t divisor) {
+    uint64_t rest = 0;
+    for (size_t i = size; i-- > 0;) {
+        uint64_t cur = (rest << kLimbBits) | limbs[i];
+        limbs[i] = static_cast<uint32_t>(cur / divisor);
+        rest = cur % divisor;
+    }
+    return static_cast<uint32_t>(rest);
+}
+
+// digits /= divisor, returns the remainder
+uint32_t divSmall(LimbVector& digits, uint32_t divisor) {
+    uint32_t rest = divSmall(digits.data(), digits.size(), divisor);
+    trim(digits);
+    return rest;
+}
+
+size_t bitLength(const LimbVector& digits) {
+    return kLimbBits * (digits.size() - 1) +
+           static_cast<size_t>(std::bit_width(digits.back()));
+}
+
+// Bits [shift, shift + 64) of the magnitude.
+uint64_t bitsAt(const LimbVector& digits, size_t shift) {
+    auto limbAt = [&digits](size_t index) -> uint64_t {
+        return index < digits.size() ? digits[index] : 0;
+    };
+    size_t limb = shift / kLimbBits;
+    size_t offset = shift % kLimbBits;
+    uint64_t low = limbAt(limb) | (limbAt(limb + 1) << kLimbBits);
+    if (offset == 0) {
+        return low;
+    }
+    return (low >> offset) | (limbAt(limb + 2) << (2 * kLimbBits - offset));
+}
+
+// Whether any of bits [0, shift) of the magnitude is set.
+bool anyBitBelow(const LimbVector& digits, size_t shift) {
+    size_t limbs = std::min(shift / kLimbBits, digits.size());
+    if (std::any_of(digits.begin(), digits.begin() + limbs,
+                    [](uint32_t limb) { return limb != 0; })) {
+        return true;
+    }
+    size_t offset = shift % kLimbBits;
+    return limbs < digits.size() && offset != 0 &&
+           (digits[limbs] & ((1U << offset) - 1)) != 0;
+}
+
+// top * 2^exponent rounded to the nearest double, ties to even, for a top
+// with bit 63 set. sticky means the exact value is slightly larger, which
+// only matters for ties. Subnormal results keep fewer mantissa bits, so
+// they are rounded once as well.
+double roundToDouble(uint64_t top, bool sticky, int64_t exponent) {
+    constexpr int64_t kMantissaBits = std::numeric_limits<double>::digits;
+    constexpr int64_t kMinExponent = std::numeric_limits<double>::min_exponent;
+    int64_t kept = std::min(kMantissaBits,
+                            exponent + 64 - kMinExponent + kMantissaBits);
+    if (kept < 0) {
+        return 0;
+    }
+    int64_t drop = 64 - kept;
+    uint64_t mantissa = drop == 64 ? 0 : top >> drop;
+    uint64_t rest = top - (mantissa << (drop % 64));
+    uint64_t half = uint64_t{1} << (drop - 1);
+    if (rest > half || (rest == half && (sticky || (mantissa & 1U) != 0))) {
+        ++mantissa;
+    }
+    return std::ldexp(static_cast<double>(mantissa),
+                      static_cast<int>(std::min<int64_t>(exponent + drop,
+                                                         kMantissaBits * 64)));
+}
+
+void shiftRightBits(LimbVector& digits, size_t shift) {
+    size_t limbs = std::min(shift / kLimbBits, digits.size());
+    size_t offset = shift % kLimbBits;
+    size_t size = digits.size() - limbs;
+    for (size_t i = 0; i < size; ++i) {
+        uint64_t cur = digits[i + limbs];
+        if (offset != 0 && i + limbs + 1 < digits.size()) {
+            cur |= static_cast<uint64_t>(digits[i + limbs + 1]) << kLimbBits;
+        }
+        digits[i] = static_cast<uint32_t>(cur >> offset);
+    }
+    digits.resize(std::max<size_t>(size, 1));
+    if (size == 0) {
+        digits[0] = 0;
+    }
+    trim(digits);
+}
+
+void shiftLeftBits(LimbVector& digits, size_t shift) {
+    if (digits.back() == 0) {
+        return;
+    }
+    size_t limbs = shift / kLimbBits;
+    size_t offset = shift % kLimbBits;
+    size_t size = digits.size();
+    digits.resize(size + limbs + 1);
+    for (size_t i = size + limbs + 1; i-- > limbs;) {
+        size_t j = i - limbs;
+        uint64_t cur = j < size ? static_cast<uint64_t>(digits[j]) << offset
+                                : 0;
+        if (offset != 0 && j >= 1) {
+            cur |= digits[j - 1] >> (kLimbBits - offset);
+        }
+        digits[i] = static_cast<uint32_t>(cur);
+    }
+    std::fill(digits.begin(), digits.begin() + limbs, 0);
+    trim(digits);
+}
+
+// Remainder of the magnitude modulo a single limb, without a quotient.
+uint32_t modSmall(const LimbVector& digits, uint32_t divisor) {
+    uint64_t rest = 0;
+    for (size_t i = digits.size(); i-- > 0;) {
+        rest = ((rest << kLimbBits) | digits[i]) % divisor;
+    }
+    return static_cast<uint32_t>(rest);
+}
+
+template <uint32_t Modulus>
+constexpr std::array<bool, Modulus> squaresModulo() {
+    std::array<bool, Modulus> answer{};
+    for (uint32_t i = 0; i < Modulus; ++i) {
+        answer[i * i % Modulus] = true;
+    }
+    return answer;
+}
+
+uint64_t powmodSmall(uint64_t base, uint64_t exponent, uint64_t modulus) {
+    uint64_t answer = 1 % modulus;
+    base %= modulus;
+    for (; exponent != 0; exponent >>= 1) {
+        if ((exponent & 1U) != 0) {
+            answer = answer * base % modulus;
+        }
+        base = base * base % modulus;
+    }
+    return answer;
+}
+
+// result = first * firstFactor - second * secondFactor, which must be
+// non-negative. result must not alias either operand.
+void mulSubMul(const LimbVector& first, uint32_t firstFactor,
+               const LimbVector& second, uint32_t secondFactor,
+               LimbVector& result) {
+    size_t size = std::max(first.size(), second.size()) + 1;
+    result.resize(size);
+    uint64_t firstCarry = 0;
+    uint64_t secondCarry = 0;
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < size; ++i) {
+        uint64_t firstLimb = i < first.size() ? first[i] : 0;
+        uint64_t secondLimb = i < second.size() ? second[i] : 0;
+        firstCarry += firstLimb * firstFactor;
+        secondCarry += secondLimb * secondFactor;
+        uint64_t cur = (firstCarry & (kLimbBase - 1)) -
+                       (secondCarry & (kLimbBase - 1)) - borrow;
+        result[i] = static_cast<uint32_t>(cur);
+        borrow = cur >> (2 * kLimbBits - 1);
+        firstCarry >>= kLimbBits;
+        secondCarry >>= kLimbBits;
+    }
+    trim(result);
+}
+
+uint64_t binaryGcd(uint64_t first, uint64_t second) {
+    if (first == 0 || second == 0) {
+        return first | second;
+    }
+    int shift = std::countr_zero(first | second);
+    first >>= std::countr_zero(first);
+    while (second != 0) {
+        second >>= std::countr_zero(second);
+        if (first > second) {
+            std::swap(first, second);
+        }
+        second -= first;
+    }
+    return first << shift;
+}
+
+// The magnitude of value when it is below 2^63, so that the word-sized
+// Rational paths can negate it and let __builtin_*_overflow catch the rest.
+bool wordMagnitude(const BigInteger& value, int64_t& out) {
+    const LimbVector& digits = value.getDigits();
+    if (digits.size() > 2 || (digits.size() == 2 && (digits[1] >> 31) != 0)) {
+        return false;
+    }
+    out = static_cast<int64_t>(bitsAt(digits, 0));
+    return true;
+}
+
+int64_t wordGcd(int64_t first, int64_t second) {
+    return static_cast<int64_t>(binaryGcd(static_cast<uint64_t>(first),
+                                          static_cast<uint64_t>(second)));
+}
+
+std::vector<uint32_t> primesUpTo(uint32_t n) {
+    std::vector<bool> composite(static_cast<size_t>(n) + 1);
+    std::vector<uint32_t> primes;
+    for (uint64_t i = 2; i <= n; ++i) {
+        if (composite[i]) {
+            continue;
+        }
+        primes.push_back(static_cast<uint32_t>(i));
+        for (uint64_t j = i * i; j <= n; j += i) {
+            composite[j] = true;
+        }
+    }
+    return primes;
+}
+
+// Product of factors, split in the middle.
+BigInteger productTree(std::span<const BigInteger> factors) {
+    if (factors.empty()) {
+        return 1;
+    }
+    if (factors.size() == 1) {
+        return factors[0];
+    }
+    size_t middle = factors.size() / 2;
+    return productTree(factors.first(middle)) *
+           productTree(factors.subspan(middle));
+}
+
+// Product of prime powers p^e; powers are packed into single limbs first.
+BigInteger primePowerProduct(
+    const std::vector<std::pair<uint32_t, uint32_t>>& powers) {
+    std::vector<BigInteger> packed;
+    uint64_t limb = 1;
+    for (auto [prime, exponent] : powers) {
+        for (uint32_t i = 0; i < exponent; ++i) {
+            if (limb * prime >= kLimbBase) {
+                packed.emplace_back(static_cast<long long>(limb));
+                limb = 1;
+            }
+            limb *= prime;
+        }
+    }
+    packed.emplace_back(static_cast<long long>(limb));
+    return productTree(packed);
+}
+
+// swing(n) = n! / ((n / 2)!)^2; p divides it floor(n / p^i) mod 2 times
+// summed over i.
+BigInteger swing(uint32_t n, const std::vector<uint32_t>& primes) {
+    std::vector<std::pair<uint32_t, uint32_t>> powers;
+    for (uint32_t prime : primes) {
+        if (prime > n) {
+            break;
+        }
+        uint32_t exponent = 0;
+        for (uint32_t rest = n / prime; rest != 0; rest /= prime) {
+            exponent += rest & 1U;
+        }
+        if (exponent != 0) {
+            powers.emplace_back(prime, exponent);
+        }
+    }
+    return primePowerProduct(powers);
+}
+
+BigInteger primeSwingFactorial(uint32_t n,
+                               const std::vector<uint32_t>& primes) {
+    if (n < 2) {
+        return 1;
+    }
+    BigInteger half = primeSwingFactorial(n / 2, primes);
+    return half * half * swing(n, primes);
+}
+
+// Runs body(i) for every i in [begin, end). When work reaches
+// kParallelLoopWork, one task per thread of the multiplication pool takes
+// the indices in turn, so uneven iterations still balance; otherwise the
+// loop is serial.
+template <typename Body>
+void parallelFor(size_t begin, size_t end, size_t work, const Body& body) {
+    unsigned threads = 0;
+    std::shared_ptr<WorkerPool> pool;
+    if (work >= kParallelLoopWork && end - begin > 1) {
+        pool = sharedPool(threads);
+    }
+    if (pool == nullptr) {
+        for (size_t i = begin; i < end; ++i) {
+            body(i);
+        }
+        return;
+    }
+    std::atomic<size_t> next = begin;
+    auto drain = [&body, &next, end] {
+        for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < end;
+             i = next.fetch_add(1, std::memory_order_relaxed)) {
+            body(i);
+        }
+    };
+    TaskGroup group(*pool);
+    for (unsigned i = 1; i < std::min<size_t>(threads, end - begin); ++i) {
+        group.run(drain);
+    }
+    drain();
+    group.wait();
+}
+
+// Bareiss' fraction-free elimination of the row-major rows x columns
+// matrix to echelon form, pivoting only in the first limit columns. After
+// the step on pivot (r, c) every entry below and right of it is a minor of
+// the input of order r + 2, so the update
+//   a[i][j] = (a[r][c] * a[i][j] - a[i][c] * a[r][j]) / previous pivot
+// divides exactly and entries grow linearly instead of exponentially.
+// Returns the pivot columns; negative flips with every row swap.
+std::vector<size_t> eliminate(std::vector<BigInteger>& entries, size_t rows,
+                              size_t columns, size_t limit, bool& negative) {
+    std::vector<size_t> pivots;
+    BigInteger previous = 1;
+    negative = false;
+    for (size_t c = 0; c < limit && pivots.size() < rows; ++c) {
+        size_t r = pivots.size();
+        size_t found = r;
+        while (found < rows && entries[found * columns + c] == 0) {
+            ++found;
+        }
+        if (found == rows) {
+            continue;
+        }
+        if (found != r) {
+            std::swap_ranges(entries.begin() + found * columns,
+                             entries.begin() + (found + 1) * columns,
+                             entries.begin() + r * columns);
+            negative = !negative;
+        }
+        const BigInteger& pivot = entries[r * columns + c];
+        size_t work = (rows - r - 1) * (columns - c) *
+                      pivot.getDigits().size() *
+                      std::max(pivot.getDigits().size(),
+                               previous.getDigits().size());
+        bool exact = previous == 1;
+        parallelFor(r + 1, rows, work, [&](size_t i) {
+            BigInteger* row = entries.data() + i * columns;
+            const BigInteger* pivotRow = entries.data() + r * columns;
+            for (size_t j = c + 1; j < columns; ++j) {
+                BigInteger value = row[j] * pivot;
+                if (row[c] != 0) {
+                    value.subMul(row[c], pivotRow[j]);
+                }
+                row[j] = exact ? std::move(value) : divExact(value, previous);
+            }
+            row[c] = 0;
+        });
+        previous = pivot;
+        pivots.push_back(c);
+    }
+    return pivots;
+}
+
+// Deterministic Miller-Rabin for n < 2^32 with the bases 2, 7 and 61.
+bool isPrimeWord(uint32_t n) {
+    if (n < 2 || n % 2 == 0) {
+        return n == 2;
+    }
+    uint32_t odd = n - 1;
+    int twos = std::countr_zero(odd);
+    odd >>= twos;
+    for (uint32_t witness : {2U, 7U, 61U}) {
+        if (witness % n == 0) {
+            continue;
+        }
+        uint64_t x = powmodSmall(witness, odd, n);
+        if (x == 1 || x == n - 1) {
+            continue;
+        }
+        for (int i = 1; i < twos && x != n - 1; ++i) {
+            x = x * x % n;
+        }
+        if (x != n - 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// (a / n) for odd n, by reciprocity on words.
+int jacobiWord(uint64_t a, uint64_t n) {
+    int answer = 1;
+    a %= n;
+    while (a != 0) {
+        int twos = std::countr_zero(a);
+        a >>= twos;
+        if ((twos & 1) != 0 && (n % 8 == 3 || n % 8 == 5)) {
+            answer = -answer;
+        }
+        std::swap(a, n);
+        if (a % 4 == 3 && n % 4 == 3) {
+            answer = -answer;
+        }
+        a %= n;
+    }
+    return n == 1 ? answer : 0;
+}
+
+// The primes below kTrialDivisionBound, grouped so that each group's
+// product fits in a limb: one modSmall per group gives the remainder by
+// every prime in it.
+struct TrialDivisors {
+    std::vector<uint32_t> primes;
+    // product of the group and the end of its primes
+    std::vector<std::pair<uint32_t, size_t>> groups;
+};
+
+const TrialDivisors& trialDivisors() {
+    static const TrialDivisors kDivisors = [] {
+        TrialDivisors divisors;
+        divisors.primes = primesUpTo(kTrialDivisionBound - 1);
+        uint64_t product = 1;
+        for (size_t i = 0; i < divisors.primes.size(); ++i) {
+            if (product * divisors.primes[i] >= kLimbBase) {
+                divisors.groups.emplace_back(static_cast<uint32_t>(product),
+                                             i);
+                product = 1;
+            }
+            product *= divisors.primes[i];
+        }
+        divisors.groups.emplace_back(static_cast<uint32_t>(product),
+                                     divisors.primes.size());
+        return divisors;
+    }();
+    return kDivisors;
+}
+
+// The determinant of the n x n matrix of residues modulo the prime p, by
+// Gaussian elimination with inverses.
+uint32_t determinantModulo(std::vector<uint32_t> entries, size_t n,
+                           uint32_t p) {
+    uint64_t answer = 1;
+    for (size_t c = 0; c < n; ++c) {
+        size_t found = c;
+        while (found < n && entries[found * n + c] == 0) {
+            ++found;
+        }
+        if (found == n) {
+            return 0;
+        }
+        if (found != c) {
+            std::swap_ranges(entries.begin() + found * n,
+                             entries.begin() + (found + 1) * n,
+                             entries.begin() + c * n);
+            answer = p - answer;
+        }
+        uint64_t pivot = entries[c * n + c];
+        answer = answer * pivot % p;
+        uint64_t inverse = powmodSmall(pivot, p - 2, p);
+        for (size_t i = c + 1; i < n; ++i) {
+            uint64_t factor = entries[i * n + c] * inverse % p;
+            if (factor == 0) {
+                continue;
+            }
+            uint64_t negated = p - factor;
+            for (size_t j = c + 1; j < n; ++j) {
+                entries[i * n + j] = static_cast<uint32_t>(
+                    (entries[i * n + j] + negated * entries[c * n + j]) % p);
+            }
+        }
+    }
+    return static_cast<uint32_t>(answer % p);
+}
+
+// Strong Lucas probable-prime test for odd n > 1 that is not a square,
+// with P = 1 and Q = (1 - D) / 4 for the first D of 5, -7, 9, -11, ...
+// with (D / n) = -1. For n + 1 = d * 2^s, n passes if U_d = 0 or
+// V_(d * 2^r) = 0 (mod n) for some r < s.
+bool isStrongLucasProbablePrime(const BigInteger& n) {
+    const LimbVector& digits = n.getDigits();
+    int64_t d = 5;
+    while (true) {
+        uint64_t magnitude = static_cast<uint64_t>(d < 0 ? -d : d);
+        int symbol = jacobiWord(modSmall(digits, static_cast<uint32_t>(
+                                                     magnitude)),
+                                magnitude);
+        if (magnitude % 4 == 3 && digits[0] % 4 == 3) {
+            symbol = -symbol;
+        }
+        if (d < 0 && digits[0] % 4 == 3) {
+            symbol = -symbol;
+        }
+        if (symbol == -1) {
+            break;
+        }
+        if (symbol == 0 && n != static_cast<long long>(magnitude)) {
+            return false;
+        }
+        d = d > 0 ? -d - 2 : -d + 2;
+    }
+    BarrettReducer reducer(n);
+    auto subtract = [&n](BigInteger first, const BigInteger& second) {
+        first -= second;
+        if (first.getNegative()) {
+            first += n;
+        }
+        return first;
+    };
+    auto half = [&n](BigInteger value) {
+        if ((value.getDigits()[0] & 1U) != 0) {
+            value += n;
+        }
+        value >>= 1;
+        return value;
+    };
+    // V_2k = V_k^2 - 2 Q^k
+    auto doubleV = [&](const BigInteger& v, const BigInteger& qk) {
+        return subtract(reducer.multiply(v, v),
+                        reducer.reduce(qk + qk));
+    };
+    BigInteger q = (1 - d) / 4;
+    if (q.getNegative()) {
+        q += n;
+    }
+    BigInteger odd = n + 1;
+    size_t twos = 0;
+    while (((odd.getDigits()[twos / kLimbBits] >> (twos % kLimbBits)) & 1U) ==
+           0) {
+        ++twos;
+    }
+    odd >>= twos;
+    BigInteger u = 1;
+    BigInteger v = 1;
+    BigInteger qk = q;
+    uint32_t absD = static_cast<uint32_t>(d < 0 ? -d : d);
+    for (size_t i = bitLength(odd.getDigits()) - 1; i-- > 0;) {
+        u = reducer.multiply(u, v);
+        v = doubleV(v, qk);
+        qk = reducer.multiply(qk, qk);
+        if (((odd.getDigits()[i / kLimbBits] >> (i % kLimbBits)) & 1U) !=
+            0) {
+            // U_(k+1) = (P U_k + V_k) / 2, V_(k+1) = (D U_k + P V_k) / 2
+            BigInteger du = u;
+            du.mulSmall(absD);
+            du = reducer.reduce(du);
+            if (d < 0 && du != 0) {
+                du = n - du;
+            }
+            u = half(subtract(u + v, n));
+            v = half(subtract(du + v, n));
+            qk = reducer.multiply(qk, q);
+        }
+    }
+    if (u == 0 || v == 0) {
+        return true;
+    }
+    for (size_t r = 1; r < twos; ++r) {
+        v = doubleV(v, qk);
+        if (v == 0) {
+            return true;
+        }
+        qk = reducer.multiply(qk, qk);
+    }
+    return false;
+}
+
+// 5^k rounded to at most `bits` bits, down or up, times 2^shift. While
+// 5^k fits both directions give it exactly.
+BigInteger powerOfFive(unsigned k, size_t bits, bool up, int64_t& shift) {
+    BigInteger answer = 1;
+    shift = 0;
+    auto truncate = [&] {
+        size_t length = answer.bitLength();
+        if (length > bits) {
+            size_t drop = length - bits;
+            bool lost = up && anyBitBelow(answer.getDigits(), drop);
+            answer >>= drop;
+            if (lost) {
+                ++answer;
+            }
+            shift += static_cast<int64_t>(drop);
+        }
+    };
+    for (auto i = static_cast<int>(std::bit_width(k)); i-- > 0;) {
+        answer.square();
+        shift *= 2;
+        truncate();
+        if (((k >> i) & 1U) != 0) {
+            answer.mulSmall(5);
+            truncate();
+        }
+    }
+    return answer;
+}
+
+bool isDecimalDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Adds the optionally signed exponent of BigFloat text to scale. The sum
+// selects an unsigned power of ten, so a larger one throws
+// std::out_of_range rather than wrapping.
+int64_t addDecimalExponent(std::string_view text, int64_t scale) {
+    bool negative = !text.empty() && text[0] == '-';
+    if (!text.empty() && (text[0] == '-' || text[0] == '+')) {
+        text.remove_prefix(1);
+    }
+    if (text.empty() ||
+        !std::all_of(text.begin(), text.end(), isDecimalDigit)) {
+        throw std::invalid_argument("BigFloat: malformed exponent");
+    }
+    constexpr int64_t kLimit = std::numeric_limits<unsigned>::max();
+    int64_t exponent = 0;
+    for (char c : text) {
+        exponent = std::min(exponent * 10 + (c - '0'), 2 * kLimit + 1);
+    }
+    scale += negative ? -exponent : exponent;
+    if (scale > kLimit || scale < -kLimit) {
+        throw std::out_of_range("BigFloat: decimal exponent out of range");
+    }
+    return scale;
+}
+
+}  // namespace
+
+LimbVector::LimbVector() = default;
+
+LimbVector::LimbVector(std::initializer_list<uint32_t> values) {
+    assign(values.begin(), values.end());
+}
+
+LimbVector::LimbVector(size_t size, uint32_t value) {
+    assign(size, value);
+}
+
+LimbVector::LimbVector(const uint32_t* first, const uint32_t* last) {
+    assign(first, last);
+}
+
+LimbVector::LimbVector(const LimbVector& other) {
+    assign(other.begin(), other.end());
+}
+
+LimbVector::LimbVector(LimbVector&& other) noexcept {
+    *this = std::move(other);
+}
+
+LimbVector& LimbVector::operator=(const LimbVector& other) {
+    if (this != &other) {
+        assign(other.begin(), other.end());
+    }
+    return *this;
+}
+
+LimbVector& LimbVector::operator=(LimbVector&& other) noexcept {
+    if (this == &other) {
+        return *this;
+    }
+    if (other.heap == nullptr) {
+        std::copy(other.local, other.local + other.count, data());
+        count = other.count;
+        other.count = 0;
+        return *this;
+    }
+    if (heap != nullptr) {
+        limbAllocator().deallocate(heap, reserved);
+    }
+    heap = std::exchange(other.heap, nullptr);
+    count = std::exchange(other.count, 0);
+    reserved = std::exchange(other.reserved, kInlineCapacity);
+    return *this;
+}
+
+LimbVector::~LimbVector() {
+    if (heap != nullptr) {
+        limbAllocator().deallocate(heap, reserved);
+    }
+}
+
+void LimbVector::grow(size_t required) {
+    size_t size = std::max(required, 2 * reserved);
+    uint32_t* buffer = limbAllocator().allocate(size);
+    std::copy(begin(), end(), buffer);
+    if (heap != nullptr) {
+        limbAllocator().deallocate(heap, reserved);
+    }
+    heap = buffer;
+    reserved = size;
+}
+
+size_t LimbVector::size() const {
+    return count;
+}
+
+bool LimbVector::empty() const {
+    return count == 0;
+}
+
+size_t LimbVector::capacity() const {
+    return reserved;
+}
+
+uint32_t* LimbVector::data() {
+    return heap != nullptr ? heap : local;
+}
+
+const uint32_t* LimbVector::data() const {
+    return heap != nullptr ? heap : local;
+}
+
+uint32_t* LimbVector::begin() {
+    return data();
+}
+
+const uint32_t* LimbVector::begin() const {
+    return data();
+}
+
+uint32_t* LimbVector::end() {
+    return data() + count;
+}
+
+const uint32_t* LimbVector::end() const {
+    return data() + count;
+}
+
+uint32_t& LimbVector::operator[](size_t index) {
+    return data()[index];
+}
+
+const uint32_t& LimbVector::operator[](size_t index) const {
+    return data()[index];
+}
+
+uint32_t& LimbVector::back() {
+    return data()[count - 1];
+}
+
+const uint32_t& LimbVector::back() const {
+    return data()[count - 1];
+}
+
+void LimbVector::reserve(size_t size) {
+    if (size > reserved) {
+        grow(size);
+    }
+}
+
+void LimbVector::resize(size_t size, uint32_t value) {
+    reserve(size);
+    if (size > count) {
+        std::fill(data() + count, data() + size, value);
+    }
+    count = size;
+}
+
+void LimbVector::push_back(uint32_t value) {
+    if (count == reserved) {
+        grow(count + 1);
+    }
+    data()[count++] = value;
+}
+
+void LimbVector::pop_back() {
+    --count;
+}
+
+void LimbVector::clear() {
+    count = 0;
+}
+
+void LimbVector::assign(size_t size, uint32_t value) {
+    count = 0;
+    resize(size, value);
+}
+
+void LimbVector::assign(const uint32_t* first, const uint32_t* last) {
+    auto size = static_cast<size_t>(last - first);
+    count = 0;
+    reserve(size);
+    std::copy(first, last, data());
+    count = size;
+}
+
+void LimbVector::insert(const uint32_t* position, size_t size,
+                        uint32_t value) {
+    auto offset = static_cast<size_t>(position - data());
+    reserve(count + size);
+    std::copy_backward(data() + offset, data() + count,
+                       data() + count + size);
+    std::fill(data() + offset, data() + offset + size, value);
+    count += size;
+}
+
+bool operator==(const LimbVector& first, const LimbVector& second) {
+    return std::equal(first.begin(), first.end(), second.begin(),
+                      second.end());
+}
+
+BigInteger::BigInteger() : digits({0}) {}
+
+BigInteger::BigInteger(long long x) : isNegative(x < 0) {
+    auto magnitude = static_cast<unsigned long long>(x);
+    if (isNegative) {
+        magnitude = 0 - magnitude;
+    }
+    while (magnitude != 0) {
+        digits.push_back(static_cast<uint32_t>(magnitude));
+        magnitude >>= kLimbBits;
+    }
+    if (digits.empty()) {
+        digits.push_back(0);
+    }
+}
+
+BigInteger::BigInteger(const std::string& s) {
+    size_t ind = 0;
+    if (!s.empty() && (s.front() == '-' || s.front() == '+')) {
+        ind = 1;
+    }
+    assignDecimal(s.data() + ind, s.size() - ind,
+                  !s.empty() && s.front() == '-');
+}
+
+const LimbVector& BigInteger::getDigits() {
+    return digits;
+}
+
+const LimbVector& BigInteger::getDigits() const {
+    return digits;
+}
+
+bool BigInteger::getNegative() const {
+    return isNegative;
+}
+
+void BigInteger::normalize() {
+    trim(digits);
+    if (digits.back() == 0) {
+        isNegative = false;
+    }
+}
+
+BigInteger& BigInteger::operator+=(const BigInteger& second) {
+    if (isNegative == second.isNegative) {
+        addAbs(digits, second.digits);
+    } else if (compareAbs(digits, second.digits) >= 0) {
+        subAbs(digits, second.digits);
+    } else {
+        subAbsReversed(digits, second.digits);
+        isNegative ^= 1;
+    }
+    normalize();
+    return *this;
+}
+
+BigInteger& BigInteger::operator-=(const BigInteger& second) {
+    if (isNegative != second.isNegative) {
+        addAbs(digits, second.digits);
+    } else if (compareAbs(digits, second.digits) >= 0) {
+        subAbs(digits, second.digits);
+    } else {
+        subAbsReversed(digits, second.digits);
+        isNegative ^= 1;
+    }
+    normalize();
+    return *this;
+}
+
+BigInteger& BigInteger::operator*=(const BigInteger& second) {
+    LimbVector product = takeSpareLimbs();
+    mulAbs(digits, second.digits, product);
+    keepSpareLimbs(std::exchange(digits, std::move(product)));
+    isNegative ^= static_cast<int>(second.isNegative);
+    normalize();
+    return *this;
+}
+
+// this += first * second (or -= when subtract is set) one row of second at a
+// time, directly in the limbs of this. When the product and this have
+// opposite signs the rows are subtracted modulo base^width; the result fits
+// in width - 1 limbs, so a set top limb means it went negative and is
+// negated back in two's complement.
+void BigInteger::mulAccumulate(const BigInteger& first,
+                               const BigInteger& second, bool subtract) {
+    if (this == &first || this == &second ||
+        std::min(first.digits.size(), second.digits.size()) >=
+            kKaratsubaThreshold) {
+        BigInteger product = first * second;
+        if (subtract) {
+            *this -= product;
+        } else {
+            *this += product;
+        }
+        return;
+    }
+    bool productNegative =
+        (first.isNegative != second.isNegative) != subtract;
+    size_t n = first.digits.size();
+    size_t width = std::max(digits.size(), n + second.digits.size()) + 1;
+    digits.resize(width);
+    for (size_t j = 0; j < second.digits.size(); ++j) {
+        uint64_t factor = second.digits[j];
+        uint64_t carry = 0;
+        if (productNegative == isNegative) {
+            for (size_t i = 0; i < n; ++i) {
+                carry += first.digits[i] * factor + digits[i + j];
+                digits[i + j] = static_cast<uint32_t>(carry);
+                carry >>= kLimbBits;
+            }
+            for (size_t i = j + n; carry != 0 && i < width; ++i) {
+                carry += digits[i];
+                digits[i] = static_cast<uint32_t>(carry);
+                carry >>= kLimbBits;
+            }
+            continue;
+        }
+        uint64_t borrow = 0;
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t product = first.digits[i] * factor + carry;
+            carry = product >> kLimbBits;
+            uint64_t cur = static_cast<uint64_t>(digits[i + j]) -
+                           static_cast<uint32_t>(product) - borrow;
+            digits[i + j] = static_cast<uint32_t>(cur);
+            borrow = cur >> (2 * kLimbBits - 1);
+        }
+        borrow += carry;
+        for (size_t i = j + n; borrow != 0 && i < width; ++i) {
+            uint64_t cur = static_cast<uint64_t>(digits[i]) - borrow;
+            digits[i] = static_cast<uint32_t>(cur);
+            borrow = cur >> (2 * kLimbBits - 1);
+        }
+    }
+    // Only a subtraction can wrap; a sum may carry into the spare limb.
+    if (productNegative != isNegative && digits.back() != 0) {
+        uint64_t carry = 1;
+        for (uint32_t& digit : digits) {
+            carry += static_cast<uint32_t>(~digit);
+            digit = static_cast<uint32_t>(carry);
+            carry >>= kLimbBits;
+        }
+        isNegative ^= 1;
+    }
+    normalize();
+}
+
+BigInteger& BigInteger::addMul(const BigInteger& first,
+                               const BigInteger& second) {
+    mulAccumulate(first, second, false);
+    return *this;
+}
+
+BigInteger& BigInteger::subMul(const BigInteger& first,
+                               const BigInteger& second) {
+    mulAccumulate(first, second, true);
+    return *this;
+}
+
+BigInteger& BigInteger::mulSmall(uint32_t factor) {
+    mulAddSmall(digits, factor, 0);
+    normalize();
+    return *this;
+}
+
+BigInteger& BigInteger::square() {
+    LimbVector product = takeSpareLimbs();
+    mulAbs(digits, digits, product);
+    keepSpareLimbs(std::exchange(digits, std::move(product)));
+    isNegative = false;
+    return *this;
+}
+
+BigInteger& BigInteger::negate() {
+    isNegative ^= 1;
+    normalize();
+    return *this;
+}
+
+BigInteger& BigInteger::abs() {
+    isNegative = false;
+    return *this;
+}
+
+BigInteger& BigInteger::operator<<=(size_t bits) {
+    shiftLeftBits(digits, bits);
+    return *this;
+}
+
+BigInteger& BigInteger::operator>>=(size_t bits) {
+    // A negative value rounds toward negative infinity: its magnitude is
+    // rounded up whenever a set bit is shifted out.
+    bool roundUp = isNegative && anyBitBelow(digits, bits);
+    shiftRightBits(digits, bits);
+    if (roundUp) {
+        digits.push_back(0);
+        uint32_t one = 1;
+        addTo(digits.data(), digits.size(), &one, 1);
+        trim(digits);
+    }
+    normalize();
+    return *this;
+}
+
+// this = this op second limb by limb on the two's complement forms, widened
+// by one limb so that the top limb holds only sign bits. op applied to the
+// sign bits gives the sign of the result.
+void BigInteger::applyBitwise(const BigInteger& second,
+                              uint32_t (*op)(uint32_t, uint32_t)) {
+    auto complement = [](uint32_t limb, bool negative, uint64_t& carry) {
+        if (!negative) {
+            return limb;
+        }
+        carry += ~limb;
+        auto answer = static_cast<uint32_t>(carry);
+        carry >>= kLimbBits;
+        return answer;
+    };
+    size_t secondSize = second.digits.size();
+    bool secondNegative = second.isNegative;
+    size_t width = std::max(digits.size(), secondSize) + 1;
+    uint32_t signs = op(isNegative ? ~0U : 0, secondNegative ? ~0U : 0);
+    bool answerNegative = signs != 0;
+    uint64_t firstCarry = 1;
+    uint64_t secondCarry = 1;
+    uint64_t answerCarry = 1;
+    digits.resize(width);
+    for (size_t i = 0; i < width; ++i) {
+        uint32_t first = complement(digits[i], isNegative, firstCarry);
+        uint32_t other = complement(i < secondSize ? second.digits[i] : 0,
+                                    secondNegative, secondCarry);
+        digits[i] = complement(op(first, other), answerNegative, answerCarry);
+    }
+    isNegative = answerNegative;
+    normalize();
+}
+
+BigInteger& BigInteger::operator&=(const BigInteger& second) {
+    applyBitwise(second, [](uint32_t a, uint32_t b) { return a & b; });
+    return *this;
+}
+
+BigInteger& BigInteger::operator|=(const BigInteger& second) {
+    applyBitwise(second, [](uint32_t a, uint32_t b) { return a | b; });
+    return *this;
+}
+
+BigInteger& BigInteger::operator^=(const BigInteger& second) {
+    applyBitwise(second, [](uint32_t a, uint32_t b) { return a ^ b; });
+    return *this;
+}
+
+size_t BigInteger::bitLength() const {
+    return ::bitLength(digits);
+}
+
+size_t BigInteger::popcount() const {
+    size_t answer = 0;
+    for (uint32_t digit : digits) {
+        answer += std::popcount(digit);
+    }
+    return answer;
+}
+
+BigInteger BigInteger::limbRange(const BigInteger& value, size_t from,
+                                 size_t to) {
+    BigInteger answer;
+    to = std::min(to, value.digits.size());
+    if (from < to) {
+        answer.digits.assign(value.digits.begin() + from,
+                             value.digits.begin() + to);
+    }
+    trim(answer.digits);
+    return answer;
+}
+
+BigInteger BigInteger::shiftedLimbs(const BigInteger& value, size_t count) {
+    BigInteger answer(value);
+    if (answer != 0) {
+        answer.digits.insert(answer.digits.begin(), count, 0);
+    }
+    return answer;
+}
+
+void BigInteger::divmodSmall(const BigInteger& first, uint32_t second,
+                             BigInteger& quotient, BigInteger& remainder) {
+    quotient.digits = first.digits;
+    remainder.digits.assign(1, divSmall(quotient.digits, second));
+}
+
+// Long division of the limbs of first by those of second, which has at
+// least two limbs. The operands are shifted so that the top bit of the
+// divisor is set, which keeps every quotient estimate at most two too
+// large. The quotient limbs are then found from the top in chunks of the
+// divisor's length, the first chunk taking what is left over; each chunk
+// leaves its remainder in place as the top of the next, so the whole
+// division works in one scratch buffer.
+void BigInteger::divmodLong(const BigInteger& first, const BigInteger& second,
+                            BigInteger& quotient, BigInteger& remainder) {
+    size_t size = first.digits.size();
+    size_t n = second.digits.size();
+    size_t length = size + 1 - n;
+    int shift = std::countl_zero(second.digits.back());
+    ScratchBuffer u(size + 1);
+    ScratchBuffer v(n);
+    ScratchBuffer product(n);
+    u[size] = shiftLimbsLeft(first.digits.data(), size, shift, u.data());
+    shiftLimbsLeft(second.digits.data(), n, shift, v.data());
+    quotient.digits.resize(length);
+    uint32_t* q = quotient.digits.data();
+    size_t at = length - length % n;
+    if (at < length) {
+        divChunk(q + at, u.data() + at, length % n, v.data(), n,
+                 product.data());
+    }
+    while (at > 0) {
+        at -= n;
+        divChunk(q + at, u.data() + at, n, v.data(), n, product.data());
+    }
+    trim(quotient.digits);
+    remainder.digits.resize(n);
+    shiftLimbsRight(u.data(), n, shift, remainder.digits.data());
+    trim(remainder.digits);
+}
+
+std::pair<BigInteger, BigInteger> divmod(const BigInteger& first,
+                                         const BigInteger& second) {
+    // The kernels read only the limbs, so the signs are set at the end.
+    std::pair<BigInteger, BigInteger> answer;
+    auto& [quotient, remainder] = answer;
+    if (compareAbs(first.digits, second.digits) < 0) {
+        remainder = first;
+        return answer;
+    }
+    if (second.digits.size() == 1) {
+        BigInteger::divmodSmall(first, second.digits[0], quotient, remainder);
+    } else {
+        BigInteger::divmodLong(first, second, quotient, remainder);
+    }
+    quotient.isNegative = (first.isNegative != second.isNegative) &&
+                          quotient != 0;
+    remainder.isNegative = first.isNegative && remainder != 0;
+    return answer;
+}
+
+// Lehmer's algorithm (Knuth, TAOCP vol. 2, 4.5.2, Algorithm L): the Euclid
+// quotients are predicted from the leading 62 bits of both operands for as
+// long as the prediction is certain, and the collected 2x2 cofactor matrix
+// is then applied to the full numbers in one linear pass. A full division
+// step is only needed when the leading bits predict nothing.
+BigInteger greatestCommonDivisor(const BigInteger& first,
+                                 const BigInteger& second) {
+    BigInteger a = first;
+    BigInteger b = second;
+    a.abs();
+    b.abs();
+    if (a < b) {
+        std::swap(a, b);
+    }
+    LimbVector nextA;
+    LimbVector nextB;
+    while (b.digits.size() > 2) {
+        size_t shift = bitLength(a.digits) - 62;
+        auto x = static_cast<int64_t>(bitsAt(a.digits, shift));
+        auto y = static_cast<int64_t>(bitsAt(b.digits, shift));
+        int64_t cofactorA = 1;
+        int64_t cofactorB = 0;
+        int64_t cofactorC = 0;
+        int64_t cofactorD = 1;
+        while (y + cofactorC > 0 && y + cofactorD > 0) {
+            int64_t q = (x + cofactorA) / (y + cofactorC);
+            if (q != (x + cofactorB) / (y + cofactorD)) {
+                break;
+            }
+            int64_t largest =
+                std::max({std::abs(cofactorC), std::abs(cofactorD),
+                          static_cast<int64_t>(1)});
+            if (q > kCofactorLimit / largest) {
+                break;
+            }
+            int64_t nextC = cofactorA - q * cofactorC;
+            int64_t nextD = cofactorB - q * cofactorD;
+            if (std::abs(nextC) > kCofactorLimit ||
+                std::abs(nextD) > kCofactorLimit) {
+                break;
+            }
+            cofactorA = std::exchange(cofactorC, nextC);
+            cofactorB = std::exchange(cofactorD, nextD);
+            x = std::exchange(y, x - q * y);
+        }
+        if (cofactorB == 0) {
+            BigInteger rest = divmod(a, b).second;
+            a = std::move(b);
+            b = std::move(rest);
+            continue;
+        }
+        // Each row of the matrix has one non-negative and one non-positive
+        // entry.
+        auto apply = [&a, &b](int64_t forA, int64_t forB, LimbVector& result) {
+            if (forB <= 0) {
+                mulSubMul(a.digits, static_cast<uint32_t>(forA), b.digits,
+                          static_cast<uint32_t>(-forB), result);
+            } else {
+                mulSubMul(b.digits, static_cast<uint32_t>(forB), a.digits,
+                          static_cast<uint32_t>(-forA), result);
+            }
+        };
+        apply(cofactorA, cofactorB, nextA);
+        apply(cofactorC, cofactorD, nextB);
+        std::swap(a.digits, nextA);
+        std::swap(b.digits, nextB);
+    }
+    if (b == 0) {
+        return a;
+    }
+    BigInteger rest = divmod(a, b).second;
+    uint64_t value = binaryGcd(bitsAt(b.digits, 0), bitsAt(rest.digits, 0));
+    BigInteger answer;
+    answer.digits = {static_cast<uint32_t>(value),
+                     static_cast<uint32_t>(value >> kLimbBits)};
+    answer.normalize();
+    return answer;
+}
+
+// Jebelean's exact division: with the divisor made odd, each quotient limb
+// is the low limb of the running remainder times the inverse of the
+// divisor's low limb modulo 2^32, so only the limbs below the quotient
+// length are ever updated.
+BigInteger divExact(const BigInteger& first, const BigInteger& second) {
+    BigInteger answer;
+    LimbVector a = first.digits;
+    LimbVector b = second.digits;
+    size_t zeros = 0;
+    while (zeros / kLimbBits + 1 < b.size() && b[zeros / kLimbBits] == 0) {
+        zeros += kLimbBits;
+    }
+    zeros += static_cast<size_t>(std::countr_zero(b[zeros / kLimbBits]));
+    shiftRightBits(a, zeros);
+    shiftRightBits(b, zeros);
+    if (b.size() == 1) {
+        answer.digits = std::move(a);
+        divSmall(answer.digits, b[0]);
+    } else if (a.size() >= b.size()) {
+        uint32_t inverse = b[0];
+        for (int i = 0; i < 4; ++i) {
+            inverse *= 2 - b[0] * inverse;
+        }
+        size_t size = a.size() - b.size() + 1;
+        answer.digits.assign(size, 0);
+        for (size_t i = 0; i < size; ++i) {
+            uint32_t q = a[i] * inverse;
+            answer.digits[i] = q;
+            uint64_t carry = 0;
+            uint64_t borrow = 0;
+            for (size_t j = 0; j < b.size() && i + j < size; ++j) {
+                uint64_t product = static_cast<uint64_t>(q) * b[j] + carry;
+                carry = product >> kLimbBits;
+                uint64_t cur = static_cast<uint64_t>(a[i + j]) -
+                               static_cast<uint32_t>(product) - borrow;
+                a[i + j] = static_cast<uint32_t>(cur);
+                borrow = cur >> (2 * kLimbBits - 1);
+            }
+            borrow += carry;
+            for (size_t j = i + b.size(); borrow != 0 && j < size; ++j) {
+                uint64_t cur = static_cast<uint64_t>(a[j]) - borrow;
+                a[j] = static_cast<uint32_t>(cur);
+                borrow = cur >> (2 * kLimbBits - 1);
+            }
+        }
+        trim(answer.digits);
+    }
+    answer.isNegative = first.isNegative != second.isNegative;
+    answer.normalize();
+    return answer;
+}
+
+// Square root by precision doubling (the algorithm of CPython's
+// math.isqrt): each round extends a root of the leading d bits to the
+// leading 2d bits with one Newton step at that precision, so only the last
+// round works with the full value.
+BigInteger isqrt(const BigInteger& value) {
+    if (value <= 0) {
+        return 0;
+    }
+    size_t c = (bitLength(value.digits) - 1) / 2;
+    BigInteger answer = 1;
+    size_t d = 0;
+    for (int s = std::bit_width(c) - 1; s >= 0; --s) {
+        size_t e = d;
+        d = c >> s;
+        BigInteger top = value >> (2 * c - e - d + 1);
+        answer = (answer << (d - e - 1)) + top / answer;
+    }
+    if (answer * answer > value) {
+        --answer;
+    }
+    return answer;
+}
+
+// Newton's iteration x -> ((k - 1) x + n / x^(k - 1)) / k decreases
+// monotonically to the root from any upper bound. The upper bound comes
+// from the root of the leading half of the bits (scaled back), so the
+// iteration starts with half of the digits correct and needs one or two
+// full-precision steps.
+BigInteger iroot(const BigInteger& value, unsigned k) {
+    if (k == 0) {
+        throw std::invalid_argument("iroot: k must be positive");
+    }
+    if (value.isNegative) {
+        return -iroot(-value, k);
+    }
+    if (k == 1 || value <= 1) {
+        return value;
+    }
+    size_t length = bitLength(value.digits);
+    size_t half = length / (2 * static_cast<size_t>(k));
+    BigInteger answer;
+    if (half == 0) {
+        BigInteger low = 0;
+        BigInteger high = BigInteger(1) << (length / k + 1);
+        while (high - low > 1) {
+            BigInteger middle = (low + high) >> 1;
+            if (pow(middle, k) <= value) {
+                low = std::move(middle);
+            } else {
+                high = std::move(middle);
+            }
+        }
+        return low;
+    }
+    answer = iroot(value >> (half * k), k) + 1;
+    answer <<= half;
+    while (true) {
+        BigInteger next = value / pow(answer, k - 1);
+        next.addMul(answer, k - 1);
+        next /= k;
+        if (next >= answer) {
+            return answer;
+        }
+        answer = std::move(next);
+    }
+}
+
+// A square is rejected cheaply unless it is a quadratic residue modulo 64,
+// 63, 65 and 11; the last three come from one remainder modulo 45045.
+bool isPerfectSquare(const BigInteger& value) {
+    if (value.isNegative) {
+        return false;
+    }
+    static constexpr auto kSquares64 = squaresModulo<64>();
+    static constexpr auto kSquares63 = squaresModulo<63>();
+    static constexpr auto kSquares65 = squaresModulo<65>();
+    static constexpr auto kSquares11 = squaresModulo<11>();
+    if (!kSquares64[value.digits[0] % 64]) {
+        return false;
+    }
+    uint32_t rest = modSmall(value.digits, 63 * 65 * 11);
+    if (!kSquares63[rest % 63] || !kSquares65[rest % 65] ||
+        !kSquares11[rest % 11]) {
+        return false;
+    }
+    BigInteger root = isqrt(value);
+    return root * root == value;
+}
+
+// Checks prime exponents k only. Before a k-th root is taken, the 2-adic
+// valuation must be a multiple of k and the value must be a k-th power
+// residue modulo a few small primes p = 1 (mod k).
+bool isPerfectPower(const BigInteger& value) {
+    BigInteger magnitude = value;
+    magnitude.abs();
+    if (magnitude <= 1) {
+        return true;
+    }
+    size_t length = bitLength(magnitude.digits);
+    size_t zeros = 0;
+    while (((magnitude.digits[zeros / kLimbBits] >> (zeros % kLimbBits)) &
+            1U) == 0) {
+        ++zeros;
+    }
+    auto isPrime = [](size_t number) {
+        for (size_t i = 2; i * i <= number; ++i) {
+            if (number % i == 0) {
+                return false;
+            }
+        }
+        return number >= 2;
+    };
+    for (size_t k = 2; k <= length; ++k) {
+        if (!isPrime(k) || (zeros != 0 && zeros % k != 0) ||
+            (value.isNegative && k == 2)) {
+            continue;
+        }
+        bool possible = true;
+        int checked = 0;
+        for (uint64_t p = 2 * k + 1; checked < 3 && p < kLimbBase;
+             p += 2 * k) {
+            if (!isPrime(p)) {
+                continue;
+            }
+            ++checked;
+            uint32_t rest =
+                modSmall(magnitude.digits, static_cast<uint32_t>(p));
+            if (rest != 0 && powmodSmall(rest, (p - 1) / k, p) != 1) {
+                possible = false;
+                break;
+            }
+        }
+        if (possible && (k != 2 || isPerfectSquare(magnitude)) &&
+            pow(iroot(magnitude, static_cast<unsigned>(k)),
+                static_cast<unsigned>(k)) == magnitude) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool isProbablePrime(const BigInteger& value) {
+    if (value <= 1) {
+        return false;
+    }
+    const LimbVector& digits = value.getDigits();
+    if (digits.size() == 1) {
+        return isPrimeWord(digits[0]);
+    }
+    const TrialDivisors& divisors = trialDivisors();
+    size_t begin = 0;
+    for (auto [product, end] : divisors.groups) {
+        uint32_t rest = modSmall(digits, product);
+        for (size_t i = begin; i < end; ++i) {
+            if (rest % divisors.primes[i] == 0) {
+                return false;
+            }
+        }
+        begin = end;
+    }
+    // Strong probable prime to base 2.
+    BigInteger odd = value - 1;
+    size_t twos = 0;
+    while (((odd.getDigits()[twos / kLimbBits] >> (twos % kLimbBits)) & 1U) ==
+           0) {
+        ++twos;
+    }
+    odd >>= twos;
+    BigInteger minusOne = value - 1;
+    BigInteger x = powmod(2, odd, value);
+    if (x != 1 && x != minusOne) {
+        BarrettReducer reducer(value);
+        for (size_t r = 1; r < twos && x != minusOne; ++r) {
+            x = reducer.multiply(x, x);
+        }
+        if (x != minusOne) {
+            return false;
+        }
+    }
+    return !isPerfectSquare(value) && isStrongLucasProbablePrime(value);
+}
+
+std::vector<bool> isProbablePrime(std::span<const BigInteger> candidates) {
+    size_t work = 0;
+    for (const BigInteger& candidate : candidates) {
+        size_t size = candidate.getDigits().size();
+        work += size * size * size;
+    }
+    // vector<bool> packs its elements, so the threads write bytes.
+    std::vector<uint8_t> primes(candidates.size());
+    parallelFor(0, candidates.size(), work, [&](size_t i) {
+        primes[i] = static_cast<uint8_t>(isProbablePrime(candidates[i]));
+    });
+    return {primes.begin(), primes.end()};
+}
+
+std::vector<BigInteger> primesInRange(const BigInteger& from, size_t length) {
+    BigInteger start = from;
+    size_t count = length;
+    if (from < 2) {
+        BigInteger end = from + static_cast<long long>(length);
+        if (end <= 2) {
+            return {};
+        }
+        start = 2;
+        count = static_cast<size_t>(bitsAt((end - 2).getDigits(), 0));
+    }
+    BigInteger last = start + static_cast<long long>(count) - 1;
+    BigInteger root = isqrt(last);
+    bool complete = root < kSieveBound;
+    std::vector<uint32_t> primes = primesUpTo(
+        complete ? static_cast<uint32_t>(root.getDigits()[0])
+                 : kSieveBound - 1);
+    // next[k]: offset from start of the next multiple of primes[k] to cross
+    // out; the prime itself is left standing.
+    std::vector<size_t> next(primes.size());
+    for (size_t k = 0; k < primes.size(); ++k) {
+        uint32_t rest = modSmall(start.getDigits(), primes[k]);
+        next[k] = rest == 0 ? 0 : primes[k] - rest;
+        if (start <= static_cast<long long>(primes[k])) {
+            next[k] += primes[k];
+        }
+    }
+    std::vector<BigInteger> candidates;
+    std::vector<bool> composite(kSieveSegment);
+    for (size_t base = 0; base < count; base += kSieveSegment) {
+        size_t size = std::min(kSieveSegment, count - base);
+        std::fill(composite.begin(), composite.end(), false);
+        for (size_t k = 0; k < primes.size(); ++k) {
+            for (; next[k] < base + size; next[k] += primes[k]) {
+                composite[next[k] - base] = true;
+            }
+        }
+        for (size_t i = 0; i < size; ++i) {
+            if (!composite[i]) {
+                candidates.push_back(start +
+                                     static_cast<long long>(base + i));
+            }
+        }
+    }
+    if (complete) {
+        return candidates;
+    }
+    std::vector<bool> primality = isProbablePrime(candidates);
+    std::vector<BigInteger> answer;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        if (primality[i]) {
+            answer.push_back(std::move(candidates[i]));
+        }
+    }
+    return answer;
+}
+
+void setMultiplicationThreads(unsigned threads) {
+    ParallelSettings& settings = parallelSettings();
+    if (threads == 0) {
+        threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    // The old pool is joined outside the lock, once the multiplications
+    // still running on it release it.
+    std::shared_ptr<WorkerPool> previous;
+    {
+        std::lock_guard<std::mutex> lock(settings.mutex);
+        settings.threads = threads;
+        previous = std::move(settings.pool);
+    }
+}
+
+void setParallelMultiplicationThreshold(size_t limbs) {
+    parallelSettings().threshold.store(
+        std::max<size_t>(limbs, kKaratsubaThreshold),
+        std::memory_order_relaxed);
+}
+
+LimbAllocator setLimbAllocator(LimbAllocator allocator) {
+    return std::exchange(limbAllocator(), allocator);
+}
+
+BigInteger product(std::span<const BigInteger> factors) {
+    return productTree(factors);
+}
+
+BigInteger factorial(unsigned n) {
+    return primeSwingFactorial(n, primesUpTo(n));
+}
+
+// p divides the binomial once per borrow when k is subtracted from n in
+// base p (Kummer), i.e. floor(n / p^i) - floor(k / p^i) -
+// floor((n - k) / p^i) summed over i.
+BigInteger binomial(unsigned n, unsigned k) {
+    if (k > n) {
+        return 0;
+    }
+    std::vector<std::pair<uint32_t, uint32_t>> powers;
+    for (uint32_t prime : primesUpTo(n)) {
+        uint32_t exponent = 0;
+        uint32_t rest = n;
+        uint32_t first = k;
+        uint32_t second = n - k;
+        while (rest != 0) {
+            rest /= prime;
+            first /= prime;
+            second /= prime;
+            exponent += rest - first - second;
+        }
+        if (exponent != 0) {
+            powers.emplace_back(prime, exponent);
+        }
+    }
+    return primePowerProduct(powers);
+}
+
+BigInteger pow(const BigInteger& base, unsigned exponent) {
+    BigInteger answer = 1;
+    for (unsigned bit = std::bit_floor(exponent); bit != 0; bit >>= 1) {
+        answer.square();
+        if ((exponent & bit) != 0) {
+            answer *= base;
+        }
+    }
+    return answer;
+}
+
+BigInteger& BigInteger::operator/=(const BigInteger& second) {
+    *this = std::move(divmod(*this, second).first);
+    return *this;
+}
+
+BigInteger& BigInteger::operator%=(const BigInteger& second) {
+    *this = std::move(divmod(*this, second).second);
+    return *this;
+}
+
+BigInteger& BigInteger::operator++() {
+    *this += 1;
+    return *this;
+}
+
+BigInteger BigInteger::operator++(int) {
+    auto it(*this);
+    ++(*this);
+    return it;
+}
+
+BigInteger& BigInteger::operator--() {
+    *this -= 1;
+    return *this;
+}
+
+BigInteger BigInteger::operator--(int) {
+    auto it(*this);
+    --(*this);
+    return it;
+}
+
+BigInteger operator+(BigInteger first, const BigInteger& second) {
+    first += second;
+    return first;
+}
+
+BigInteger operator+(const BigInteger& first, BigInteger&& second) {
+    second += first;
+    return std::move(second);
+}
+
+BigInteger operator-(BigInteger first, const BigInteger& second) {
+    first -= second;
+    return first;
+}
+
+BigInteger operator-(const BigInteger& first, BigInteger&& second) {
+    second -= first;
+    second.negate();
+    return std::move(second);
+}
+
+BigInteger operator-(BigInteger first) {
+    first.negate();
+    return first;
+}
+
+BigInteger operator*(BigInteger first, const BigInteger& second) {
+    first *= second;
+    return first;
+}
+
+BigInteger operator*(const BigInteger& first, BigInteger&& second) {
+    second *= first;
+    return std::move(second);
+}
+
+BigInteger operator/(BigInteger first, const BigInteger& second) {
+    first /= second;
+    return first;
+}
+
+BigInteger operator%(BigInteger first, const BigInteger& second) {
+    first %= second;
+    return first;
+}
+
+BigInteger operator<<(BigInteger value, size_t bits) {
+    value <<= bits;
+    return value;
+}
+
+BigInteger operator>>(BigInteger value, size_t bits) {
+    value >>= bits;
+    return value;
+}
+
+BigInteger operator&(BigInteger first, const BigInteger& second) {
+    first &= second;
+    return first;
+}
+
+BigInteger operator|(BigInteger first, const BigInteger& second) {
+    first |= second;
+    return first;
+}
+
+BigInteger operator^(BigInteger first, const BigInteger& second) {
+    first ^= second;
+    return first;
+}
+
+bool operator==(const BigInteger& first, const BigInteger& second) {
+    return first.getNegative() == second.getNegative() &&
+           first.getDigits() == second.getDigits();
+}
+
+bool operator!=(const BigInteger& first, const BigInteger& second) {
+    return !(first == second);
+}
+
+bool operator<(const BigInteger& first, const BigInteger& second) {
+    if (first.getNegative() != second.getNegative()) {
+        return first.getNegative();
+    }
+    int order = compareAbs(first.getDigits(), second.getDigits());
+    return first.getNegative() ? order > 0 : order < 0;
+}
+
+bool operator>(const BigInteger& first, const BigInteger& second) {
+    return second < first;
+}
+
+bool operator<=(const BigInteger& first, const BigInteger& second) {
+    return !(first > second);
+}
+
+bool operator>=(const BigInteger& first, const BigInteger& second) {
+    return !(first < second);
+}
+
+// powers[k] = 10^(9 * 2^k), extended on demand.
+const BigInteger& BigInteger::decimalPower(std::vector<BigInteger>& powers,
+                                           size_t k) {
+    if (powers.empty()) {
+        powers.emplace_back(static_cast<long long>(kDecimalChunk));
+    }
+    while (powers.size() <= k) {
+        powers.push_back(powers.back() * powers.back());
+    }
+    return powers[k];
+}
+
+// digits = digits * 10^size + s[0, size), one 9-digit chunk at a time
+void BigInteger::parseChunks(const char* s, size_t size) {
+    size_t head = size % kDecimalChunkDigits;
+    if (head != 0) {
+        uint32_t value = 0;
+        uint32_t power = 1;
+        for (size_t i = 0; i < head; ++i) {
+            value = value * 10 + static_cast<uint32_t>(s[i] - '0');
+            power *= 10;
+        }
+        mulAddSmall(digits, power, value);
+    }
+    for (size_t ind = head; ind < size; ind += kDecimalChunkDigits) {
+        uint32_t value = static_cast<uint32_t>(s[ind] - '0') * 100'000'000 +
+                         parseEightDigits(s + ind + 1);
+        mulAddSmall(digits, kDecimalChunk, value);
+    }
+}
+
+// Short inputs are parsed into the limbs already held, keeping their
+// capacity; long ones go through parseDecimal.
+void BigInteger::assignDecimal(const char* s, size_t size, bool negative) {
+    if (size <= kDecimalConversionThreshold * kDecimalChunkDigits) {
+        digits.assign(1, 0);
+        parseChunks(s, size);
+    } else {
+        std::vector<BigInteger> powers;
+        *this = parseDecimal(s, size, powers);
+    }
+    isNegative = negative;
+    normalize();
+}
+
+BigInteger BigInteger::parseDecimal(const char* s, size_t size,
+                                    std::vector<BigInteger>& powers) {
+    BigInteger answer;
+    if (size <= kDecimalConversionThreshold * kDecimalChunkDigits) {
+        answer.parseChunks(s, size);
+        return answer;
+    }
+    size_t k = 0;
+    while ((kDecimalChunkDigits << (k + 1)) < size) {
+        ++k;
+    }
+    size_t lowSize = kDecimalChunkDigits << k;
+    answer = parseDecimal(s, size - lowSize, powers);
+    answer *= decimalPower(powers, k);
+    answer += parseDecimal(s + size - lowSize, lowSize, powers);
+    return answer;
+}
+
+// Writes the magnitude of value to sink, left-padded with zeros to width
+// digits (width == 0 means no padding). Large values are split as
+// q * 10^(9 * 2^k) + r with the divisor about half the size of the value,
+// so the work is dominated by a few big divisions instead of a quadratic
+// number of single-limb ones.
+template <typename Sink>
+void BigInteger::writeDecimal(const BigInteger& value, size_t width,
+                              std::vector<BigInteger>& powers, Sink& sink) {
+    static constexpr size_t kZerosSize = 64;
+    static constexpr char kZeros[kZerosSize + 1] =
+        "0000000000000000000000000000000000000000000000000000000000000000";
+    auto writeZeros = [&sink](size_t count) {
+        for (; count > kZerosSize; count -= kZerosSize) {
+            sink(kZeros, kZerosSize);
+        }
+        sink(kZeros, count);
+    };
+    size_t size = value.digits.size();
+    if (size <= kDecimalConversionThreshold) {
+        // A limb holds fewer than two chunks.
+        ScratchBuffer rest(size);
+        ScratchBuffer chunks(2 * size);
+        std::copy(value.digits.begin(), value.digits.end(), rest.data());
+        size_t count = 0;
+        do {
+            chunks[count++] = divSmall(rest.data(), size, kDecimalChunk);
+            while (size > 1 && rest[size - 1] == 0) {
+                --size;
+            }
+        } while (rest[size - 1] != 0);
+        char buffer[kDecimalChunkDigits];
+        size_t top = kDecimalChunkDigits;
+        uint32_t chunk = chunks[count - 1];
+        do {
+            buffer[--top] = static_cast<char>('0' + chunk % 10);
+            chunk /= 10;
+        } while (chunk != 0);
+        size_t natural = kDecimalChunkDigits * count - top;
+        if (width > natural) {
+            writeZeros(width - natural);
+        }
+        sink(buffer + top, kDecimalChunkDigits - top);
+        for (size_t i = count - 1; i-- > 0;) {
+            chunk = chunks[i];
+            for (size_t j = kDecimalChunkDigits; j-- > 0; chunk /= 10) {
+                buffer[j] = static_cast<char>('0' + chunk % 10);
+            }
+            sink(buffer, kDecimalChunkDigits);
+        }
+        return;
+    }
+    size_t k = 0;
+    while (4 * decimalPower(powers, k).digits.size() <= size + 3) {
+        ++k;
+    }
+    size_t lowWidth = kDecimalChunkDigits << k;
+    auto [quotient, remainder] = divmod(value, decimalPower(powers, k));
+    if (quotient != 0 || width > lowWidth) {
+        writeDecimal(quotient, width > lowWidth ? width - lowWidth : 0,
+                     powers, sink);
+        writeDecimal(remainder, lowWidth, powers, sink);
+    } else {
+        writeDecimal(remainder, width, powers, sink);
+    }
+}
+
+size_t BigInteger::hash() const {
+    return static_cast<size_t>(
+        hashLimbs(digits, static_cast<uint64_t>(isNegative)));
+}
+
+double BigInteger::toDouble() const {
+    size_t length = ::bitLength(digits);
+    if (length == 0) {
+        return 0;
+    }
+    uint64_t top = 0;
+    bool sticky = false;
+    if (length <= 64) {
+        top = bitsAt(digits, 0) << (64 - length);
+    } else {
+        top = bitsAt(digits, length - 64);
+        sticky = anyBitBelow(digits, length - 64);
+    }
+    double answer =
+        roundToDouble(top, sticky, static_cast<int64_t>(length) - 64);
+    return isNegative ? -answer : answer;
+}
+
+BigInteger BigInteger::fromDouble(double value) {
+    if (!std::isfinite(value)) {
+        return 0;
+    }
+    int exponent = 0;
+    double fraction = std::frexp(std::trunc(value), &exponent);
+    constexpr int kMantissaBits = std::numeric_limits<double>::digits;
+    BigInteger answer(static_cast<long long>(
+        std::ldexp(std::abs(fraction), kMantissaBits)));
+    exponent -= kMantissaBits;
+    if (exponent >= 0) {
+        answer <<= static_cast<size_t>(exponent);
+    } else {
+        answer >>= static_cast<size_t>(-exponent);
+    }
+    if (value < 0) {
+        answer.negate();
+    }
+    return answer;
+}
+
+size_t BigInteger::serializedSize() const {
+    size_t count = digits.back() == 0 ? 0 : digits.size();
+    return varintSize(2 * count + static_cast<uint64_t>(isNegative)) +
+           count * kLimbBytes;
+}
+
+size_t BigInteger::serialize(std::span<uint8_t> out) const {
+    size_t size = serializedSize();
+    if (out.size() < size) {
+        return 0;
+    }
+    size_t count = digits.back() == 0 ? 0 : digits.size();
+    uint64_t header = 2 * count + static_cast<uint64_t>(isNegative);
+    writeVarint(header, out.data());
+    storeLimbs(digits.data(), count, out.data() + varintSize(header));
+    return size;
+}
+
+size_t BigInteger::deserialize(std::span<const uint8_t> in) {
+    std::optional<BigIntegerView> view = BigIntegerView::parse(in);
+    if (!view) {
+        return 0;
+    }
+    view->assignTo(*this);
+    return view->serializedSize();
+}
+
+std::string BigInteger::toString() const {
+    std::string answer;
+    if (isNegative) {
+        answer += '-';
+    }
+    std::vector<BigInteger> powers;
+    auto sink = [&answer](const char* data, size_t size) {
+        answer.append(data, size);
+    };
+    writeDecimal(*this, 0, powers, sink);
+    return answer;
+}
+
+BigInteger operator""_bi(const char* value, size_t /*unused*/) {
+    BigInteger answer(value);
+    return answer;
+}
+
+BigInteger operator""_bi(unsigned long long value) {
+    BigInteger answer;
+    answer.digits.clear();
+    do {
+        answer.digits.push_back(static_cast<uint32_t>(value));
+        value >>= kLimbBits;
+    } while (value != 0);
+    return answer;
+}
+
+// Reads an optional sign and the digits straight from the stream buffer;
+// the first non-digit is left in the stream, and a missing number sets
+// failbit and leaves result unchanged. The digits are parsed into limbs a
+// block at a time, and pieces of equal length are merged as soon as they
+// pair up, like the digits of a binary counter: only one block of text is
+// held, and the merging stays divide and conquer.
+std::istream& operator>>(std::istream& is, BigInteger& result) {
+    std::istream::sentry sentry(is);
+    if (!sentry) {
+        return is;
+    }
+    std::streambuf* buffer = is.rdbuf();
+    auto isDigit = [](int symbol) { return symbol >= '0' && symbol <= '9'; };
+    int symbol = buffer->sgetc();
+    bool negative = symbol == '-';
+    if (symbol == '-' || symbol == '+') {
+        symbol = buffer->snextc();
+    }
+    bool found = false;
+    for (; symbol == '0'; symbol = buffer->snextc()) {
+        found = true;
+    }
+    std::array<char, kDecimalChunkDigits << kStreamBlockLevel> block;
+    size_t filled = 0;
+    std::vector<BigInteger> powers;
+    // Each piece is 9 * 2^level digits, more significant ones first.
+    std::vector<std::pair<BigInteger, size_t>> pieces;
+    for (; isDigit(symbol); symbol = buffer->snextc()) {
+        block[filled++] = static_cast<char>(symbol);
+        if (filled < block.size()) {
+            continue;
+        }
+        BigInteger piece =
+            BigInteger::parseDecimal(block.data(), filled, powers);
+        size_t level = kStreamBlockLevel;
+        for (; !pieces.empty() && pieces.back().second == level; ++level) {
+            piece +=
+                pieces.back().first * BigInteger::decimalPower(powers, level);
+            pieces.pop_back();
+        }
+        pieces.emplace_back(std::move(piece), level);
+        filled = 0;
+    }
+    if (symbol == std::istream::traits_type::eof()) {
+        is.setstate(std::ios_base::eofbit);
+    }
+    if (!found && filled == 0 && pieces.empty()) {
+        is.setstate(std::ios_base::failbit);
+        return is;
+    }
+    BigInteger answer = BigInteger::parseDecimal(block.data(), filled, powers);
+    BigInteger shift = pow(BigInteger(10), static_cast<unsigned>(filled));
+    for (size_t i = pieces.size(); i-- > 0;) {
+        answer += pieces[i].first * shift;
+        if (i != 0) {
+            shift *= BigInteger::decimalPower(powers, pieces[i].second);
+        }
+    }
+    result = std::move(answer);
+    result.isNegative = negative;
+    result.normalize();
+    return is;
+}
+
+std::ostream& operator<<(std::ostream& os, const BigInteger& toPrint) {
+    if (os.width() != 0) {
+        return os << toPrint.toString();
+    }
+    std::ostream::sentry sentry(os);
+    if (!sentry) {
+        return os;
+    }
+    std::streambuf* buffer = os.rdbuf();
+    bool failed = false;
+    auto sink = [buffer, &failed](const char* data, size_t size) {
+        auto count = static_cast<std::streamsize>(size);
+        failed = failed || buffer->sputn(data, count) != count;
+    };
+    if (toPrint.isNegative) {
+        sink("-", 1);
+    }
+    std::vector<BigInteger> powers;
+    BigInteger::writeDecimal(toPrint, 0, powers, sink);
+    if (failed) {
+        os.setstate(std::ios_base::badbit);
+    }
+    return os;
+}
+
+size_t serialize(std::span<const BigInteger> values, std::span<uint8_t> out) {
+    size_t total = 0;
+    for (const BigInteger& value : values) {
+        total += value.serializedSize();
+    }
+    if (out.size() < total) {
+        return 0;
+    }
+    size_t offset = 0;
+    for (const BigInteger& value : values) {
+        offset += value.serialize(out.subspan(offset));
+    }
+    return offset;
+}
+
+size_t deserialize(std::span<const uint8_t> in, std::span<BigInteger> values) {
+    size_t offset = 0;
+    for (BigInteger& value : values) {
+        size_t size = value.deserialize(in.subspan(offset));
+        if (size == 0) {
+            return 0;
+        }
+        offset += size;
+    }
+    return offset;
+}
+
+// Rejects headers with the sign set on zero and limbs with a zero top limb,
+// so every value has exactly one binary form.
+std::optional<BigIntegerView> BigIntegerView::parse(
+    std::span<const uint8_t> in) {
+    uint64_t header = 0;
+    size_t headerSize = readVarint(in, header);
+    if (headerSize == 0) {
+        return std::nullopt;
+    }
+    BigIntegerView view;
+    view.count = header >> 1;
+    view.isNegative = (header & 1U) != 0;
+    if (view.count > (in.size() - headerSize) / kLimbBytes) {
+        return std::nullopt;
+    }
+    view.limbs = in.data() + headerSize;
+    view.encodedSize = headerSize + view.count * kLimbBytes;
+    if (view.count == 0 ? view.isNegative : view[view.count - 1] == 0) {
+        return std::nullopt;
+    }
+    return view;
+}
+
+bool BigIntegerView::getNegative() const {
+    return isNegative;
+}
+
+size_t BigIntegerView::size() const {
+    return count;
+}
+
+uint32_t BigIntegerView::operator[](size_t index) const {
+    return loadLimb(limbs + index * kLimbBytes);
+}
+
+size_t BigIntegerView::serializedSize() const {
+    return encodedSize;
+}
+
+BigInteger BigIntegerView::toBigInteger() const {
+    BigInteger answer;
+    assignTo(answer);
+    return answer;
+}
+
+void BigIntegerView::assignTo(BigInteger& value) const {
+    value.digits.resize(std::max<size_t>(count, 1));
+    value.digits[0] = 0;
+    if constexpr (std::endian::native == std::endian::little) {
+        std::memcpy(value.digits.data(), limbs, count * kLimbBytes);
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            value.digits[i] = (*this)[i];
+        }
+    }
+    value.isNegative = isNegative;
+}
+
+BigInteger::operator bool() {
+    return (*this) != 0;
+}
+
+MontgomeryContext::MontgomeryContext(const BigInteger& modulus)
+    : modulus(modulus.digits) {
+    size_t n = this->modulus.size();
+    BigInteger absolute = modulus;
+    absolute.abs();
+    one = (BigInteger::shiftedLimbs(1, n) % absolute).digits;
+    one.resize(n);
+    rSquared = (BigInteger::shiftedLimbs(1, 2 * n) % absolute).digits;
+    rSquared.resize(n);
+    uint32_t low = this->modulus[0];
+    uint32_t value = low;
+    for (int i = 0; i < 4; ++i) {
+        value *= 2 - low * value;
+    }
+    inverse = 0 - value;
+    scratch.resize(n + 2);
+}
+
+// out = first * second / R mod N, coarsely integrated operand scanning
+// (Koc, Acar, Kaliski 1996). out may alias either operand.
+void MontgomeryContext::multiply(const uint32_t* first, const uint32_t* second,
+                                 uint32_t* out) {
+    size_t n = modulus.size();
+    uint32_t* t = scratch.data();
+    std::fill(t, t + n + 2, 0);
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < n; ++j) {
+            carry += static_cast<uint64_t>(first[j]) * second[i] + t[j];
+            t[j] = static_cast<uint32_t>(carry);
+            carry >>= kLimbBits;
+        }
+        carry += t[n];
+        t[n] = static_cast<uint32_t>(carry);
+        t[n + 1] = static_cast<uint32_t>(carry >> kLimbBits);
+        uint32_t factor = t[0] * inverse;
+        carry = (static_cast<uint64_t>(factor) * modulus[0] + t[0]) >>
+                kLimbBits;
+        for (size_t j = 1; j < n; ++j) {
+            carry += static_cast<uint64_t>(factor) * modulus[j] + t[j];
+            t[j - 1] = static_cast<uint32_t>(carry);
+            carry >>= kLimbBits;
+        }
+        carry += t[n];
+        t[n - 1] = static_cast<uint32_t>(carry);
+        t[n] = t[n + 1] + static_cast<uint32_t>(carry >> kLimbBits);
+    }
+    bool reduce = t[n] != 0;
+    for (size_t j = n; !reduce && j-- > 0;) {
+        if (t[j] != modulus[j]) {
+            reduce = t[j] > modulus[j];
+            break;
+        }
+        reduce = j == 0;
+    }
+    if (reduce) {
+        subFrom(t, n, modulus.data(), n);
+    }
+    std::copy(t, t + n, out);
+}
+
+LimbVector MontgomeryContext::toResidue(const BigInteger& value) {
+    BigInteger absolute;
+    absolute.digits = modulus;
+    BigInteger reduced = value % absolute;
+    if (reduced < 0) {
+        reduced += absolute;
+    }
+    LimbVector residue = std::move(reduced.digits);
+    residue.resize(modulus.size());
+    multiply(residue.data(), rSquared.data(), residue.data());
+    return residue;
+}
+
+// Left-to-right sliding window over the exponent bits with a table of the
+// odd powers base^1, base^3, ..., base^(2^window - 1).
+BigInteger MontgomeryContext::powmod(const BigInteger& base,
+                                     const BigInteger& exponent) {
+    size_t n = modulus.size();
+    const LimbVector& bits = exponent.digits;
+    size_t length = bitLength(bits);
+    size_t window = 1;
+    for (size_t limit : {24, 80, 240, 672}) {
+        window += static_cast<size_t>(length > limit);
+    }
+    auto bitAt = [&bits](size_t index) {
+        return (bits[index / kLimbBits] >> (index % kLimbBits)) & 1U;
+    };
+    table.resize(size_t{1} << (window - 1));
+    table[0] = toResidue(base);
+    if (table.size() > 1) {
+        LimbVector square(n, 0);
+        multiply(table[0].data(), table[0].data(), square.data());
+        for (size_t k = 1; k < table.size(); ++k) {
+            table[k].resize(n);
+            multiply(table[k - 1].data(), square.data(), table[k].data());
+        }
+    }
+    LimbVector result = one;
+    bool started = false;
+    for (size_t i = length; i-- > 0;) {
+        if (bitAt(i) == 0) {
+            if (started) {
+                multiply(result.data(), result.data(), result.data());
+            }
+            continue;
+        }
+        size_t low = i + 1 >= window ? i + 1 - window : 0;
+        while (bitAt(low) == 0) {
+            ++low;
+        }
+        uint32_t value = 0;
+        for (size_t j = i + 1; j-- > low;) {
+            value = 2 * value + bitAt(j);
+            if (started) {
+                multiply(result.data(), result.data(), result.data());
+            }
+        }
+        if (started) {
+            multiply(result.data(), table[value / 2].data(), result.data());
+        } else {
+            result = table[value / 2];
+            started = true;
+        }
+        i = low;
+    }
+    LimbVector unit(n, 0);
+    unit[0] = 1;
+    multiply(result.data(), unit.data(), result.data());
+    BigInteger answer;
+    answer.digits = std::move(result);
+    answer.normalize();
+    return answer;
+}
+
+BarrettReducer::BarrettReducer(const BigInteger& modulus)
+    : modulus(modulus), size(modulus.digits.size()) {
+    this->modulus.abs();
+    mu = BigInteger::shiftedLimbs(1, 2 * size) / this->modulus;
+}
+
+// Handbook of Applied Cryptography, Algorithm 14.42.
+BigInteger BarrettReducer::reduce(const BigInteger& value) const {
+    if (value.isNegative || value.digits.size() > 2 * size) {
+        BigInteger answer = value % modulus;
+        if (answer.isNegative) {
+            answer += modulus;
+        }
+        return answer;
+    }
+    BigInteger quotient = BigInteger::limbRange(value, size - 1,
+                                                value.digits.size());
+    quotient *= mu;
+    quotient = BigInteger::limbRange(quotient, size + 1,
+                                     quotient.digits.size());
+    BigInteger answer = value;
+    answer.subMul(quotient, modulus);
+    while (answer >= modulus) {
+        answer -= modulus;
+    }
+    return answer;
+}
+
+BigInteger BarrettReducer::multiply(const BigInteger& first,
+                                    const BigInteger& second) const {
+    return reduce(first * second);
+}
+
+BigInteger powmod(const BigInteger& base, const BigInteger& exponent,
+                  const BigInteger& modulus) {
+    if (modulus == 1 || modulus == -1) {
+        return 0;
+    }
+    if ((modulus.getDigits()[0] & 1U) != 0) {
+        return MontgomeryContext(modulus).powmod(base, exponent);
+    }
+    BarrettReducer reducer(modulus);
+    BigInteger power = reducer.reduce(base);
+    BigInteger answer = 1;
+    const LimbVector& bits = exponent.getDigits();
+    for (size_t i = bitLength(bits); i-- > 0;) {
+        answer = reducer.multiply(answer, answer);
+        if (((bits[i / kLimbBits] >> (i % kLimbBits)) & 1U) != 0) {
+            answer = reducer.multiply(answer, power);
+        }
+    }
+    return answer;
+}
+
+BigIntegerAccumulator::BigIntegerAccumulator(size_t carryPeriod)
+    : carryPeriod(std::clamp<size_t>(carryPeriod, 1, kMaxCarryPeriod)) {}
+
+// Leaves every column below 2^32; a carry out of the top adds columns.
+void BigIntegerAccumulator::propagate(std::vector<uint64_t>& columns) {
+    uint64_t carry = 0;
+    for (uint64_t& column : columns) {
+        carry += column;
+        column = static_cast<uint32_t>(carry);
+        carry >>= kLimbBits;
+    }
+    for (; carry != 0; carry >>= kLimbBits) {
+        columns.push_back(static_cast<uint32_t>(carry));
+    }
+}
+
+BigInteger BigIntegerAccumulator::collect(std::vector<uint64_t> columns) {
+    propagate(columns);
+    BigInteger answer;
+    answer.digits.resize(std::max<size_t>(columns.size(), 1));
+    std::copy(columns.begin(), columns.end(), answer.digits.begin());
+    answer.normalize();
+    return answer;
+}
+
+void BigIntegerAccumulator::add(const BigInteger& term, bool subtract) {
+    if (pending == carryPeriod) {
+        normalize();
+    }
+    std::vector<uint64_t>& columns =
+        term.getNegative() != subtract ? negative : positive;
+    const LimbVector& digits = term.getDigits();
+    if (columns.size() < digits.size()) {
+        columns.resize(digits.size());
+    }
+    addColumns(columns.data(), digits.data(), digits.size());
+    ++pending;
+}
+
+BigIntegerAccumulator& BigIntegerAccumulator::operator+=(
+    const BigInteger& term) {
+    add(term, false);
+    return *this;
+}
+
+BigIntegerAccumulator& BigIntegerAccumulator::operator-=(
+    const BigInteger& term) {
+    add(term, true);
+    return *this;
+}
+
+void BigIntegerAccumulator::normalize() {
+    propagate(positive);
+    propagate(negative);
+    pending = 0;
+}
+
+BigInteger BigIntegerAccumulator::value() const {
+    return collect(positive) - collect(negative);
+}
+
+Rational::Rational() {
+    numerator = 0;
+    denominator = 1;
+}
+
+Rational::Rational(long long first) {
+    numerator = first;
+    denominator = 1;
+    isNegative ^= static_cast<int>(first < 0);
+    if (numerator < 0) {
+        numerator *= -1;
+    }
+}
+
+Rational::Rational(BigInteger first) {
+    numerator = first;
+    denominator = 1;
+    isNegative ^= static_cast<int>(first.getNegative());
+    if (numerator < 0) {
+        numerator *= -1;
+    }
+}
+
+Rational::Rational(BigInteger first, BigInteger second) {
+    isNegative = first.getNegative() != second.getNegative();
+    numerator = std::move(first.abs());
+    denominator = std::move(second.abs());
+    int64_t a = 0;
+    int64_t b = 0;
+    if (wordMagnitude(numerator, a) && wordMagnitude(denominator, b) &&
+        b != 0) {
+        int64_t divisor = wordGcd(a, b);
+        numerator = a / divisor;
+        denominator = b / divisor;
+    } else {
+        gcd(numerator, denominator);
+    }
+    normalize();
+}
+
+void gcd(BigInteger& first, BigInteger& second) {
+    BigInteger divisor = greatestCommonDivisor(first, second);
+    if (divisor != 0 && divisor != 1) {
+        first = divExact(first, divisor);
+        second = divExact(second, divisor);
+    }
+}
+
+const BigInteger& Rational::getDenominator() const {
+    return denominator;
+}
+
+const BigInteger& Rational::getNumerator() const {
+    return numerator;
+}
+
+void Rational::normalize() {
+    if (numerator == 0) {
+        denominator = 1;
+        isNegative = false;
+    }
+}
+
+// Henrici's addition: with g = gcd(b, d), a/b + c/d = t / (b/g * d) for
+// t = a * (d/g) + c * (b/g), and only gcd(t, g) can still divide out. Both
+// operands are reduced, so no gcd of the full-size result is needed.
+void Rational::accumulate(const Rational& second, bool subtract) {
+    if (accumulateWords(second, subtract)) {
+        return;
+    }
+    if (this == &second) {
+        Rational copy = second;
+        accumulate(copy, subtract);
+        return;
+    }
+    BigInteger first = numerator;
+    if (isNegative) {
+        first.negate();
+    }
+    BigInteger other = second.numerator;
+    if (second.isNegative != subtract) {
+        other.negate();
+    }
+    BigInteger divisor = greatestCommonDivisor(denominator, second.denominator);
+    if (divisor == 1) {
+        numerator = std::move(first) * second.denominator;
+        numerator.addMul(other, denominator);
+        denominator *= second.denominator;
+    } else {
+        BigInteger secondScale = divExact(second.denominator, divisor);
+        numerator = std::move(first) * secondScale;
+        numerator.addMul(other, divExact(denominator, divisor));
+        BigInteger common = greatestCommonDivisor(numerator, divisor);
+        if (common != 1) {
+            numerator = divExact(numerator, common);
+            denominator = divExact(denominator, common);
+        }
+        denominator *= secondScale;
+    }
+    isNegative = numerator.getNegative();
+    numerator.abs();
+    normalize();
+}
+
+// accumulate with every numerator and denominator below 2^63: the same
+// steps in int64_t, giving up with *this untouched on the first overflow.
+bool Rational::accumulateWords(const Rational& second, bool subtract) {
+    int64_t a = 0;
+    int64_t b = 0;
+    int64_t c = 0;
+    int64_t d = 0;
+    if (!wordMagnitude(numerator, a) || !wordMagnitude(denominator, b) ||
+        !wordMagnitude(second.numerator, c) ||
+        !wordMagnitude(second.denominator, d)) {
+        return false;
+    }
+    if (isNegative) {
+        a = -a;
+    }
+    if (second.isNegative != subtract) {
+        c = -c;
+    }
+    int64_t divisor = wordGcd(b, d);
+    int64_t secondScale = d / divisor;
+    int64_t first = 0;
+    int64_t other = 0;
+    int64_t sum = 0;
+    if (__builtin_mul_overflow(a, secondScale, &first) ||
+        __builtin_mul_overflow(c, b / divisor, &other) ||
+        __builtin_add_overflow(first, other, &sum) ||
+        sum == std::numeric_limits<int64_t>::min()) {
+        return false;
+    }
+    int64_t magnitude = sum < 0 ? -sum : sum;
+    int64_t common = wordGcd(magnitude, divisor);
+    int64_t product = 0;
+    if (__builtin_mul_overflow(b / common, secondScale, &product)) {
+        return false;
+    }
+    numerator = magnitude / common;
+    denominator = product;
+    isNegative = sum < 0;
+    normalize();
+    return true;
+}
+
+// multiply on magnitudes below 2^63, false with *this untouched when the
+// product overflows.
+bool Rational::multiplyWords(const BigInteger& secondNumerator,
+                             const BigInteger& secondDenominator) {
+    int64_t a = 0;
+    int64_t b = 0;
+    int64_t c = 0;
+    int64_t d = 0;
+    if (!wordMagnitude(numerator, a) || !wordMagnitude(denominator, b) ||
+        !wordMagnitude(secondNumerator, c) ||
+        !wordMagnitude(secondDenominator, d) || d == 0) {
+        return false;
+    }
+    int64_t first = wordGcd(a, d);
+    int64_t second = wordGcd(c, b);
+    int64_t product = 0;
+    int64_t quotient = 0;
+    if (__builtin_mul_overflow(a / first, c / second, &product) ||
+        __builtin_mul_overflow(b / second, d / first, &quotient)) {
+        return false;
+    }
+    numerator = product;
+    denominator = quotient;
+    return true;
+}
+
+// Cross-reduces a/b * c/d by gcd(a, d) and gcd(c, b) before multiplying.
+void Rational::multiply(const BigInteger& secondNumerator,
+                        const BigInteger& secondDenominator) {
+    if (multiplyWords(secondNumerator, secondDenominator)) {
+        return;
+    }
+    BigInteger first = greatestCommonDivisor(numerator, secondDenominator);
+    BigInteger second = greatestCommonDivisor(secondNumerator, denominator);
+    BigInteger otherNumerator = divExact(secondNumerator, second);
+    BigInteger otherDenominator = divExact(secondDenominator, first);
+    numerator = divExact(numerator, first);
+    numerator *= otherNumerator;
+    denominator = divExact(denominator, second);
+    denominator *= otherDenominator;
+}
+
+Rational& Rational::operator+=(const Rational& second) {
+    accumulate(second, false);
+    return *this;
+}
+
+Rational& Rational::operator-=(const Rational& second) {
+    accumulate(second, true);
+    return *this;
+}
+
+Rational& Rational::operator*=(const Rational& second) {
+    multiply(second.numerator, second.denominator);
+    isNegative ^= static_cast<int>(second.isNegative);
+    normalize();
+    return *this;
+}
+
+Rational& Rational::operator/=(const Rational& second) {
+    multiply(second.denominator, second.numerator);
+    isNegative ^= static_cast<int>(second.isNegative);
+    normalize();
+    return *this;
+}
+
+Rational& Rational::operator++() {
+    accumulate(1, false);
+    return *this;
+}
+
+Rational Rational::operator++(int) {
+    auto it(*this);
+    ++(*this);
+    return it;
+}
+
+Rational& Rational::operator--() {
+    accumulate(1, true);
+    return *this;
+}
+
+Rational Rational::operator--(int) {
+    auto it(*this);
+    --(*this);
+    return it;
+}
+
+Rational operator+(const Rational& first, const Rational& second) {
+    Rational answer(first);
+    answer += second;
+    return answer;
+}
+
+Rational operator-(const Rational& first, const Rational& second) {
+    Rational answer(first);
+    answer -= second;
+    return answer;
+}
+
+Rational operator-(const Rational& first) {
+    return (0 - first);
+}
+
+Rational operator*(Rational first, const Rational& second) {
+    first *= second;
+    return first;
+}
+
+Rational operator/(Rational first, const Rational& second) {
+    first /= second;
+    return first;
+}
+
+bool operator==(const Rational& first, const Rational& second) {
+    return first.getSign() == second.getSign() &&
+           first.getNumerator() == second.getNumerator() &&
+           first.getDenominator() == second.getDenominator();
+}
+
+bool operator!=(const Rational& first, const Rational& second) {
+    return !(first == second);
+}
+
+bool operator<(const Rational& first, const Rational& second) {
+    if (first.getSign() != second.getSign()) {
+        return first.getSign();
+    }
+    int64_t a = 0;
+    int64_t b = 0;
+    int64_t c = 0;
+    int64_t d = 0;
+    int64_t left = 0;
+    int64_t right = 0;
+    if (wordMagnitude(first.getNumerator(), a) &&
+        wordMagnitude(first.getDenominator(), b) &&
+        wordMagnitude(second.getNumerator(), c) &&
+        wordMagnitude(second.getDenominator(), d) &&
+        !__builtin_mul_overflow(a, d, &left) &&
+        !__builtin_mul_overflow(c, b, &right)) {
+        return first.getSign() ? right < left : left < right;
+    }
+    int firstSign = 1, secondSign = 1;
+    if (first.getSign()) {
+        firstSign = -1;
+    }
+    if (second.getSign()) {
+        secondSign = -1;
+    }
+    return (firstSign * first.getNumerator() * second.getDenominator() -
+                secondSign * second.getNumerator() * first.getDenominator() <
+            0);
+}
+
+bool operator<=(const Rational& first, const Rational& second) {
+    return !(first > second);
+}
+
+bool operator>(const Rational& first, const Rational& second) {
+    return second < first;
+}
+
+bool operator>=(const Rational& first, const Rational& second) {
+    return !(first < second);
+}
+
+std::string Rational::toString() const {
+    std::string answer;
+    if (isNegative) {
+        answer += '-';
+    }
+    answer += numerator.toString();
+    if (denominator == 1 || numerator == 0) {
+        return answer;
+    }
+    answer += '/' + denominator.toString();
+    return answer;
+}
+
+long long BigInteger::getBase() const {
+    return base;
+}
+
+std::string Rational::asDecimal(size_t precision) const {
+    std::string answer;
+    appendDecimal(answer, precision);
+    return answer;
+}
+
+// The fraction is expanded nine digits at a time: the remainder is
+// multiplied by 10^9 and divided by the denominator, a one-limb quotient.
+// Both are scaled so that the top limb of the denominator has its high bit
+// set; the quotient estimated from the top two limbs of the remainder is
+// then at most two too large (Knuth's algorithm D).
+// The sign is written only if some printed digit is nonzero, so values
+// truncated to zero print as 0, not -0.
+void Rational::appendDecimal(std::string& out, size_t precision) const {
+    auto [whole, remainder] = divmod(numerator, denominator);
+    size_t start = out.size();
+    if (isNegative) {
+        out += '-';
+    }
+    out += whole.toString();
+    if (precision != 0) {
+        appendFraction(out, std::move(remainder), precision);
+    }
+    if (isNegative && out.find_first_not_of("0.", start + 1) == out.npos) {
+        out.erase(start, 1);
+    }
+}
+
+// Appends '.' and the first precision digits of remainder / denominator.
+void Rational::appendFraction(std::string& out, BigInteger remainder,
+                              size_t precision) const {
+    out += '.';
+    size_t shift = (kLimbBits - denominator.bitLength() % kLimbBits) %
+                   kLimbBits;
+    BigInteger divisor = denominator << shift;
+    remainder <<= shift;
+    size_t n = divisor.getDigits().size();
+    uint64_t leading = divisor.getDigits().back();
+    out.reserve(out.size() + precision);
+    for (size_t written = 0; written < precision;
+         written += kDecimalChunkDigits) {
+        remainder.mulSmall(kDecimalChunk);
+        const LimbVector& limbs = remainder.getDigits();
+        uint64_t top = limbs.size() > n ? limbs[n] : 0;
+        uint64_t next = limbs.size() > n - 1 ? limbs[n - 1] : 0;
+        uint64_t chunk = std::min<uint64_t>(
+            ((top << kLimbBits) | next) / leading, kDecimalChunk - 1);
+        remainder.subMul(divisor, static_cast<long long>(chunk));
+        while (remainder.getNegative()) {
+            remainder += divisor;
+            --chunk;
+        }
+        char buffer[kDecimalChunkDigits];
+        for (size_t j = kDecimalChunkDigits; j-- > 0; chunk /= 10) {
+            buffer[j] = static_cast<char>('0' + chunk % 10);
+        }
+        out.append(buffer, std::min(kDecimalChunkDigits, precision - written));
+    }
+}
+
+// numerator * 2^shift / denominator is made to have 64 or 65 bits; the
+// quotient is truncated to exactly 64 and everything cut off (the
+// remainder or the dropped bit) goes into the sticky bit.
+double Rational::toDouble() const {
+    if (numerator == 0) {
+        return 0;
+    }
+    auto shift = static_cast<int64_t>(denominator.bitLength()) -
+                 static_cast<int64_t>(numerator.bitLength()) + 64;
+    BigInteger dividend = numerator;
+    BigInteger divisor = denominator;
+    if (shift >= 0) {
+        dividend <<= static_cast<size_t>(shift);
+    } else {
+        divisor <<= static_cast<size_t>(-shift);
+    }
+    auto [quotient, remainder] = divmod(dividend, divisor);
+    bool sticky = remainder != 0;
+    if (quotient.bitLength() > 64) {
+        sticky |= (quotient.getDigits()[0] & 1U) != 0;
+        quotient >>= 1;
+        --shift;
+    }
+    uint64_t top = quotient.getDigits()[0] |
+                   (static_cast<uint64_t>(quotient.getDigits()[1]) << 32);
+    double answer = roundToDouble(top, sticky, -shift);
+    return isNegative ? -answer : answer;
+}
+
+Rational Rational::fromDouble(double value) {
+    if (!std::isfinite(value) || value == 0) {
+        return 0;
+    }
+    int exponent = 0;
+    double fraction = std::frexp(value, &exponent);
+    constexpr int kMantissaBits = std::numeric_limits<double>::digits;
+    auto mantissa =
+        static_cast<long long>(std::ldexp(fraction, kMantissaBits));
+    exponent -= kMantissaBits;
+    int zeros = std::countr_zero(static_cast<uint64_t>(std::abs(mantissa)));
+    mantissa /= (1LL << zeros);
+    exponent += zeros;
+    if (exponent >= 0) {
+        return BigInteger(mantissa) << static_cast<size_t>(exponent);
+    }
+    Rational answer(mantissa);
+    answer.denominator <<= static_cast<size_t>(-exponent);
+    return answer;
+}
+
+Rational::operator double() const {
+    return toDouble();
+}
+
+size_t Rational::serializedSize() const {
+    return numerator.serializedSize() + denominator.serializedSize();
+}
+
+size_t Rational::serialize(std::span<uint8_t> out) const {
+    size_t size = serializedSize();
+    if (out.size() < size) {
+        return 0;
+    }
+    // The sign is the lowest bit of the numerator's header, so it can be
+    // set in the first byte after writing the magnitude.
+    size_t offset = numerator.serialize(out);
+    out[0] |= static_cast<uint8_t>(isNegative);
+    denominator.serialize(out.subspan(offset));
+    return size;
+}
+
+size_t Rational::deserialize(std::span<const uint8_t> in) {
+    std::optional<BigIntegerView> first = BigIntegerView::parse(in);
+    if (!first) {
+        return 0;
+    }
+    std::optional<BigIntegerView> second =
+        BigIntegerView::parse(in.subspan(first->serializedSize()));
+    if (!second || second->getNegative() || second->size() == 0) {
+        return 0;
+    }
+    // Only lowest terms are accepted: == and hash compare the fields.
+    BigInteger top = first->toBigInteger();
+    BigInteger bottom = second->toBigInteger();
+    if (top == 0 ? first->getNegative() || bottom != 1
+                 : greatestCommonDivisor(top, bottom) != 1) {
+        return 0;
+    }
+    isNegative = top.getNegative();
+    numerator = std::move(top);
+    numerator.abs();
+    denominator = std::move(bottom);
+    return first->serializedSize() + second->serializedSize();
+}
+
+bool Rational::getSign() const {
+    return isNegative;
+}
+
+// numerator and denominator are coprime and the sign is kept apart, so
+// equal values have identical fields.
+size_t Rational::hash() const {
+    uint64_t first = hashLimbs(numerator.getDigits(),
+                               static_cast<uint64_t>(isNegative));
+    uint64_t second = hashLimbs(denominator.getDigits(), 2);
+    return static_cast<size_t>(mixBits(first ^ std::rotl(second, 17)));
+}
+
+RationalAccumulator::RationalAccumulator(size_t reductionLimbs)
+    : reductionLimbs(reductionLimbs), nextReduction(reductionLimbs) {}
+
+RationalAccumulator::RationalAccumulator(const Rational& initial,
+                                         size_t reductionLimbs)
+    : numerator(initial.getNumerator()),
+      denominator(initial.getDenominator()),
+      reductionLimbs(reductionLimbs),
+      nextReduction(reductionLimbs) {
+    if (initial.getSign()) {
+        numerator.negate();
+    }
+}
+
+void RationalAccumulator::add(const Rational& term, bool subtract) {
+    BigInteger termNumerator = term.getNumerator();
+    if (term.getSign() != subtract) {
+        termNumerator.negate();
+    }
+    if (denominator == term.getDenominator()) {
+        numerator += termNumerator;
+    } else if (term.getDenominator() == 1) {
+        numerator.addMul(termNumerator, denominator);
+    } else {
+        numerator *= term.getDenominator();
+        numerator.addMul(termNumerator, denominator);
+        denominator *= term.getDenominator();
+    }
+    if (std::max(numerator.getDigits().size(),
+                 denominator.getDigits().size()) > nextReduction) {
+        normalize();
+    }
+}
+
+RationalAccumulator& RationalAccumulator::operator+=(const Rational& term) {
+    add(term, false);
+    return *this;
+}
+
+RationalAccumulator& RationalAccumulator::operator-=(const Rational& term) {
+    add(term, true);
+    return *this;
+}
+
+// A sum whose reduced form is itself large would otherwise be reduced again
+// on every term, so the next threshold is kept at twice the reduced size.
+void RationalAccumulator::normalize() {
+    gcd(numerator, denominator);
+    if (numerator == 0) {
+        denominator = 1;
+    }
+    nextReduction =
+        std::max(reductionLimbs, 2 * std::max(numerator.getDigits().size(),
+                                              denominator.getDigits().size()));
+}
+
+Rational RationalAccumulator::value() const {
+    return {numerator, denominator};
+}
+
+std::string RationalAccumulator::toString() const {
+    return value().toString();
+}
+
+bool operator==(const RationalAccumulator& first, const Rational& second) {
+    return first.value() == second;
+}
+
+bool operator!=(const RationalAccumulator& first, const Rational& second) {
+    return !(first == second);
+}
+
+bool operator<(const RationalAccumulator& first, const Rational& second) {
+    return first.value() < second;
+}
+
+bool operator>(const RationalAccumulator& first, const Rational& second) {
+    return first.value() > second;
+}
+
+bool operator<=(const RationalAccumulator& first, const Rational& second) {
+    return first.value() <= second;
+}
+
+bool operator>=(const RationalAccumulator& first, const Rational& second) {
+    return first.value() >= second;
+}
+
+BigIntegerMatrix::BigIntegerMatrix(size_t rows, size_t columns)
+    : rowCount(rows), columnCount(columns), entries(rows * columns) {}
+
+BigIntegerMatrix::BigIntegerMatrix(
+    std::initializer_list<std::initializer_list<BigInteger>> rows)
+    : rowCount(rows.size()),
+      columnCount(rows.size() == 0 ? 0 : rows.begin()->size()) {
+    entries.reserve(rowCount * columnCount);
+    for (const std::initializer_list<BigInteger>& row : rows) {
+        if (row.size() != columnCount) {
+            throw std::invalid_argument("BigIntegerMatrix: ragged rows");
+        }
+        entries.insert(entries.end(), row.begin(), row.end());
+    }
+}
+
+size_t BigIntegerMatrix::rows() const {
+    return rowCount;
+}
+
+size_t BigIntegerMatrix::columns() const {
+    return columnCount;
+}
+
+BigInteger& BigIntegerMatrix::operator()(size_t row, size_t column) {
+    return entries[row * columnCount + column];
+}
+
+const BigInteger& BigIntegerMatrix::operator()(size_t row,
+                                               size_t column) const {
+    return entries[row * columnCount + column];
+}
+
+// The last Bareiss pivot is the determinant of the row-swapped matrix.
+BigInteger BigIntegerMatrix::determinant() const {
+    if (rowCount == 0) {
+        return 1;
+    }
+    std::vector<BigInteger> work = entries;
+    bool negative = false;
+    if (eliminate(work, rowCount, columnCount, columnCount, negative)
+            .size() < rowCount) {
+        return 0;
+    }
+    BigInteger answer = std::move(work.back());
+    if (negative) {
+        answer.negate();
+    }
+    return answer;
+}
+
+// |det| is at most the product of the row norms (Hadamard), and every
+// prime is above 2^30, so bound / 30 + 1 primes determine the symmetric
+// residue of the determinant.
+BigInteger BigIntegerMatrix::modularDeterminant() const {
+    size_t n = rowCount;
+    if (n == 0) {
+        return 1;
+    }
+    size_t boundBits = 1;
+    for (size_t i = 0; i < n; ++i) {
+        BigInteger norm;
+        for (size_t j = 0; j < n; ++j) {
+            norm.addMul(entries[i * n + j], entries[i * n + j]);
+        }
+        if (norm == 0) {
+            return 0;
+        }
+        boundBits += (norm.bitLength() + 1) / 2;
+    }
+    std::vector<uint32_t> primes;
+    for (uint32_t candidate = (1U << 31) - 1;
+         primes.size() < boundBits / 30 + 1; candidate -= 2) {
+        if (isPrimeWord(candidate)) {
+            primes.push_back(candidate);
+        }
+    }
+    std::vector<uint32_t> residues(primes.size());
+    parallelFor(0, primes.size(), primes.size() * n * n * n,
+                [&](size_t k) {
+                    uint32_t p = primes[k];
+                    std::vector<uint32_t> reduced(n * n);
+                    for (size_t i = 0; i < n * n; ++i) {
+                        uint32_t rest = modSmall(entries[i].getDigits(), p);
+                        reduced[i] = entries[i].getNegative() && rest != 0
+                                         ? p - rest
+                                         : rest;
+                    }
+                    residues[k] = determinantModulo(std::move(reduced), n, p);
+                });
+    // Garner: answer += modulus * ((r - answer) / modulus mod p).
+    BigInteger answer;
+    BigInteger modulus = 1;
+    for (size_t k = 0; k < primes.size(); ++k) {
+        uint32_t p = primes[k];
+        uint64_t difference =
+            (residues[k] + p - modSmall(answer.getDigits(), p)) % p;
+        uint64_t inverse =
+            powmodSmall(modSmall(modulus.getDigits(), p), p - 2, p);
+        answer.addMul(modulus,
+                      static_cast<long long>(difference * inverse % p));
+        modulus.mulSmall(p);
+    }
+    if (answer > modulus / 2) {
+        answer -= modulus;
+    }
+    return answer;
+}
+
+size_t BigIntegerMatrix::rank() const {
+    std::vector<BigInteger> work = entries;
+    bool negative = false;
+    return eliminate(work, rowCount, columnCount, columnCount, negative)
+        .size();
+}
+
+// Bareiss on [A | b] leaves an upper triangular U whose last pivot d is
+// +-det A, and y = d * x is integral by Cramer's rule, so back substitution
+// y[i] = (d * U[i][n] - sum U[i][j] * y[j]) / U[i][i] divides exactly.
+std::optional<std::vector<Rational>> BigIntegerMatrix::solve(
+    std::span<const BigInteger> rhs) const {
+    size_t n = rowCount;
+    size_t width = n + 1;
+    std::vector<BigInteger> work(n * width);
+    for (size_t i = 0; i < n; ++i) {
+        std::copy(entries.begin() + i * n, entries.begin() + (i + 1) * n,
+                  work.begin() + i * width);
+        work[i * width + n] = rhs[i];
+    }
+    bool negative = false;
+    if (eliminate(work, n, width, n, negative).size() < n) {
+        return std::nullopt;
+    }
+    if (n == 0) {
+        return std::vector<Rational>();
+    }
+    const BigInteger& d = work[n * width - 2];
+    std::vector<BigInteger> scaled(n);
+    std::vector<Rational> answer(n);
+    for (size_t i = n; i-- > 0;) {
+        BigInteger value = work[i * width + n] * d;
+        for (size_t j = i + 1; j < n; ++j) {
+            value.subMul(work[i * width + j], scaled[j]);
+        }
+        scaled[i] = divExact(value, work[i * width + i]);
+        answer[i] = Rational(scaled[i], d);
+    }
+    return answer;
+}
+
+std::optional<std::vector<Rational>> solve(
+    const std::vector<std::vector<Rational>>& matrix,
+    const std::vector<Rational>& rhs) {
+    size_t n = matrix.size();
+    BigIntegerMatrix scaled(n, n);
+    std::vector<BigInteger> scaledRhs(n);
+    for (size_t i = 0; i < n; ++i) {
+        BigInteger common = rhs[i].getDenominator();
+        for (const Rational& value : matrix[i]) {
+            BigInteger divisor =
+                greatestCommonDivisor(common, value.getDenominator());
+            common *= divExact(value.getDenominator(), divisor);
+        }
+        auto scale = [&common](const Rational& value) {
+            BigInteger answer = divExact(common, value.getDenominator()) *
+                                value.getNumerator();
+            if (value.getSign()) {
+                answer.negate();
+            }
+            return answer;
+        };
+        for (size_t j = 0; j < n; ++j) {
+            scaled(i, j) = scale(matrix[i][j]);
+        }
+        scaledRhs[i] = scale(rhs[i]);
+    }
+    return scaled.solve(scaledRhs);
+}
+
+BigFloat::BigFloat(long long value) : BigFloat(BigInteger(value)) {}
+
+BigFloat::BigFloat(const BigInteger& value)
+    : mantissa(value),
+      precision(std::max<size_t>(value.bitLength(), kDefaultPrecision)) {
+    round();
+}
+
+BigFloat::BigFloat(const BigInteger& value, size_t precision)
+    : mantissa(value), precision(std::max<size_t>(precision, 1)) {
+    round();
+}
+
+BigFloat::BigFloat(const Rational& value, size_t precision)
+    : precision(std::max<size_t>(precision, 1)) {
+    BigInteger numerator = value.getNumerator();
+    if (value.getSign()) {
+        numerator.negate();
+    }
+    assignQuotient(std::move(numerator), value.getDenominator(), 0);
+}
+
+BigFloat::BigFloat(const char* text, size_t precision)
+    : BigFloat(std::string_view(text), precision) {}
+
+BigFloat::BigFloat(const std::string& text, size_t precision)
+    : BigFloat(std::string_view(text), precision) {}
+
+// The digits are read as one integer n and the value is n * 10^scale,
+// rounded once: a product for scale >= 0, a quotient otherwise. Writing
+// 10^k = 5^k * 2^k, the value is bracketed between n times 5^k rounded
+// down and rounded up to a working width, which doubles until both ends
+// round alike; 10^k itself is only built when that takes all its bits.
+BigFloat::BigFloat(std::string_view text, size_t precision)
+    : precision(std::max<size_t>(precision, 1)) {
+    bool negative = !text.empty() && text[0] == '-';
+    if (!text.empty() && (text[0] == '-' || text[0] == '+')) {
+        text.remove_prefix(1);
+    }
+    std::string digits;
+    int64_t scale = 0;
+    bool point = false;
+    size_t i = 0;
+    for (; i < text.size() && text[i] != 'e' && text[i] != 'E'; ++i) {
+        if (text[i] == '.' && !point) {
+            point = true;
+        } else if (isDecimalDigit(text[i])) {
+            digits += text[i];
+            scale -= static_cast<int64_t>(point);
+        } else {
+            throw std::invalid_argument("BigFloat: malformed decimal");
+        }
+    }
+    if (digits.empty()) {
+        throw std::invalid_argument("BigFloat: no digits");
+    }
+    if (i < text.size()) {
+        scale = addDecimalExponent(text.substr(i + 1), scale);
+    }
+    BigInteger value(digits);
+    if (value == 0) {
+        return;
+    }
+    auto k = static_cast<unsigned>(scale < 0 ? -scale : scale);
+    for (size_t bits = this->precision + 64;; bits *= 2) {
+        int64_t lowShift = 0;
+        int64_t highShift = 0;
+        BigInteger low = powerOfFive(k, bits, false, lowShift);
+        BigInteger high = powerOfFive(k, bits, true, highShift);
+        BigFloat below = *this;
+        BigFloat above = *this;
+        if (scale >= 0) {
+            below.mantissa = value * low;
+            below.exponent = scale + lowShift;
+            below.round();
+            above.mantissa = value * high;
+            above.exponent = scale + highShift;
+            above.round();
+        } else {
+            below.assignQuotient(value, high, scale - highShift);
+            above.assignQuotient(value, low, scale - lowShift);
+        }
+        if (below == above) {
+            *this = std::move(below);
+            break;
+        }
+    }
+    if (negative) {
+        mantissa.negate();
+    }
+}
+
+const BigInteger& BigFloat::getMantissa() const {
+    return mantissa;
+}
+
+int64_t BigFloat::getExponent() const {
+    return exponent;
+}
+
+size_t BigFloat::getPrecision() const {
+    return precision;
+}
+
+BigFloat& BigFloat::setPrecision(size_t bits) {
+    precision = std::max<size_t>(bits, 1);
+    round();
+    return *this;
+}
+
+// Rounds mantissa to precision bits, to nearest with ties to even, then
+// moves its trailing zero bits into the exponent.
+void BigFloat::round() {
+    if (mantissa == 0) {
+        exponent = 0;
+        return;
+    }
+    size_t length = mantissa.bitLength();
+    bool negative = mantissa.getNegative();
+    if (length > precision) {
+        size_t shift = length - precision;
+        const LimbVector& digits = mantissa.getDigits();
+        bool half = ((digits[(shift - 1) / kLimbBits] >>
+                      ((shift - 1) % kLimbBits)) &
+                     1U) != 0;
+        bool sticky = anyBitBelow(digits, shift - 1);
+        mantissa.abs();
+        mantissa >>= shift;
+        if (half && (sticky || (mantissa.getDigits()[0] & 1U) != 0)) {
+            ++mantissa;
+        }
+        if (negative) {
+            mantissa.negate();
+        }
+        exponent += static_cast<int64_t>(shift);
+    }
+    size_t zeros = 0;
+    const LimbVector& digits = mantissa.getDigits();
+    while (digits[zeros / kLimbBits] == 0) {
+        zeros += kLimbBits;
+    }
+    zeros += static_cast<size_t>(std::countr_zero(digits[zeros / kLimbBits]));
+    if (zeros != 0) {
+        mantissa.abs();
+        mantissa >>= zeros;
+        if (negative) {
+            mantissa.negate();
+        }
+        exponent += static_cast<int64_t>(zeros);
+    }
+}
+
+// dividend / divisor * 2^scale for a positive divisor. The quotient is
+// taken with at least precision + 2 bits and a sticky bit for a nonzero
+// remainder appended, which rounds exactly like the full quotient.
+void BigFloat::assignQuotient(BigInteger dividend, const BigInteger& divisor,
+                              int64_t scale) {
+    bool negative = dividend.getNegative();
+    dividend.abs();
+    if (dividend == 0) {
+        mantissa = 0;
+        exponent = 0;
+        return;
+    }
+    int64_t shift = static_cast<int64_t>(precision + 2 +
+                                         divisor.bitLength()) -
+                    static_cast<int64_t>(dividend.bitLength());
+    shift = std::max<int64_t>(shift, 0);
+    dividend <<= static_cast<size_t>(shift);
+    auto [quotient, remainder] = divmod(dividend, divisor);
+    quotient <<= 1;
+    if (remainder != 0) {
+        ++quotient;
+    }
+    if (negative) {
+        quotient.negate();
+    }
+    mantissa = std::move(quotient);
+    exponent = scale - shift - 1;
+    round();
+}
+
+// When the smaller operand lies entirely more than two bits below the
+// larger one, no cancellation can happen and the result's rounding
+// boundaries are multiples of 2^(L + 1) for L = top - precision - 3.
+// Everything of the smaller operand below 2^L is then replaced by half a
+// unit there, which keeps the sum strictly between the same multiples of
+// 2^L and so rounds the same, without shifting by the exponent gap.
+void BigFloat::add(const BigFloat& second, bool subtract) {
+    precision = std::max(precision, second.precision);
+    BigInteger other = second.mantissa;
+    if (subtract) {
+        other.negate();
+    }
+    if (other == 0) {
+        round();
+        return;
+    }
+    if (mantissa == 0) {
+        mantissa = std::move(other);
+        exponent = second.exponent;
+        round();
+        return;
+    }
+    int64_t firstTop =
+        exponent + static_cast<int64_t>(mantissa.bitLength());
+    int64_t secondTop =
+        second.exponent + static_cast<int64_t>(other.bitLength());
+    bool firstLarger = firstTop >= secondTop;
+    BigInteger large = firstLarger ? std::move(mantissa) : other;
+    BigInteger small = firstLarger ? std::move(other) : mantissa;
+    int64_t largeExponent = firstLarger ? exponent : second.exponent;
+    int64_t smallExponent = firstLarger ? second.exponent : exponent;
+    int64_t largeTop = std::max(firstTop, secondTop);
+    int64_t smallTop = std::min(firstTop, secondTop);
+    int64_t low = std::min(
+        largeExponent, largeTop - static_cast<int64_t>(precision) - 3);
+    if (smallTop < largeTop - 2 && smallExponent < low) {
+        bool negative = small.getNegative();
+        small.abs();
+        auto drop = static_cast<uint64_t>(low - smallExponent);
+        if (drop >= small.bitLength()) {
+            small = 1;
+        } else {
+            bool inexact = anyBitBelow(small.getDigits(), drop);
+            small >>= drop;
+            small <<= 1;
+            if (inexact) {
+                ++small;
+            }
+        }
+        if (negative) {
+            small.negate();
+        }
+        smallExponent = low - 1;
+    }
+    int64_t base = std::min(largeExponent, smallExponent);
+    large <<= static_cast<size_t>(largeExponent - base);
+    small <<= static_cast<size_t>(smallExponent - base);
+    mantissa = std::move(large);
+    mantissa += small;
+    exponent = base;
+    round();
+}
+
+BigFloat& BigFloat::operator+=(const BigFloat& second) {
+    add(second, false);
+    return *this;
+}
+
+BigFloat& BigFloat::operator-=(const BigFloat& second) {
+    add(second, true);
+    return *this;
+}
+
+BigFloat& BigFloat::operator*=(const BigFloat& second) {
+    precision = std::max(precision, second.precision);
+    mantissa *= second.mantissa;
+    exponent += second.exponent;
+    round();
+    return *this;
+}
+
+BigFloat& BigFloat::operator/=(const BigFloat& second) {
+    precision = std::max(precision, second.precision);
+    BigInteger divisor = second.mantissa;
+    BigInteger dividend = std::move(mantissa);
+    if (divisor.getNegative()) {
+        divisor.negate();
+        dividend.negate();
+    }
+    assignQuotient(std::move(dividend), divisor,
+                   exponent - second.exponent);
+    return *this;
+}
+
+Rational BigFloat::toRational() const {
+    if (exponent >= 0) {
+        return {mantissa << static_cast<size_t>(exponent)};
+    }
+    return {mantissa, BigInteger(1) << static_cast<size_t>(-exponent)};
+}
+
+// floor(|value| * 10^precision) is an exact shift of the mantissa times a
+// power of ten; the point goes in front of its last precision digits.
+std::string BigFloat::asDecimal(size_t precision) const {
+    BigInteger scaled = mantissa;
+    scaled.abs();
+    scaled *= pow(BigInteger(10), static_cast<unsigned>(precision));
+    if (exponent >= 0) {
+        scaled <<= static_cast<size_t>(exponent);
+    } else {
+        scaled >>= static_cast<size_t>(-exponent);
+    }
+    std::string digits = scaled.toString();
+    if (digits.size() <= precision) {
+        digits.insert(0, precision + 1 - digits.size(), '0');
+    }
+    if (precision != 0) {
+        digits.insert(digits.end() - static_cast<std::ptrdiff_t>(precision),
+                      '.');
+    }
+    if (mantissa.getNegative()) {
+        digits.insert(digits.begin(), '-');
+    }
+    return digits;
+}
+
+// isqrt of the mantissa shifted to an even exponent and at least
+// 2 * (precision + 2) bits, with a sticky bit for an inexact root.
+BigFloat sqrt(const BigFloat& value) {
+    BigFloat answer;
+    answer.precision = value.precision;
+    if (value.mantissa <= 0) {
+        return answer;
+    }
+    int64_t shift = std::max<int64_t>(
+        static_cast<int64_t>(2 * (value.precision + 2)) -
+            static_cast<int64_t>(value.mantissa.bitLength()),
+        0);
+    if (((value.exponent - shift) & 1) != 0) {
+        ++shift;
+    }
+    BigInteger scaled = value.mantissa << static_cast<size_t>(shift);
+    BigInteger root = isqrt(scaled);
+    bool inexact = root * root != scaled;
+    root <<= 1;
+    if (inexact) {
+        ++root;
+    }
+    answer.mantissa = std::move(root);
+    answer.exponent = (value.exponent - shift) / 2 - 1;
+    answer.round();
+    return answer;
+}
+
+BigFloat operator+(const BigFloat& first, const BigFloat& second) {
+    BigFloat answer = first;
+    answer += second;
+    return answer;
+}
+
+BigFloat operator-(const BigFloat& first, const BigFloat& second) {
+    BigFloat answer = first;
+    answer -= second;
+    return answer;
+}
+
+BigFloat operator-(const BigFloat& value) {
+    return value * BigFloat(BigInteger(-1), 1);
+}
+
+BigFloat operator*(const BigFloat& first, const BigFloat& second) {
+    BigFloat answer = first;
+    answer *= second;
+    return answer;
+}
+
+BigFloat operator/(const BigFloat& first, const BigFloat& second) {
+    BigFloat answer = first;
+    answer /= second;
+    return answer;
+}
+
+bool operator==(const BigFloat& first, const BigFloat& second) {
+    return first.getExponent() == second.getExponent() &&
+           first.getMantissa() == second.getMantissa();
+}
+
+bool operator!=(const BigFloat& first, const BigFloat& second) {
+    return !(first == second);
+}
+
+// The signs, then the positions of the leading bits decide; only values
+// with the same leading bit are aligned, by less than their lengths.
+bool operator<(const BigFloat& first, const BigFloat& second) {
+    const BigInteger& a = first.getMantissa();
+    const BigInteger& b = second.getMantissa();
+    if (a.getNegative() != b.getNegative() || a == 0 || b == 0) {
+        return a < b;
+    }
+    int64_t firstTop =
+        first.getExponent() + static_cast<int64_t>(a.bitLength());
+    int64_t secondTop =
+        second.getExponent() + static_cast<int64_t>(b.bitLength());
+    if (firstTop != secondTop) {
+        return (firstTop < secondTop) != a.getNegative();
+    }
+    int64_t base = std::min(first.getExponent(), second.getExponent());
+    return (a << static_cast<size_t>(first.getExponent() - base)) <
+           (b << static_cast<size_t>(second.getExponent() - base));
+}
+
+bool operator<=(const BigFloat& first, const BigFloat& second) {
+    return !(second < first);
+}
+
+bool operator>(const BigFloat& first, const BigFloat& second) {
+    return second < first;
+}
+
+bool operator>=(const BigFloat& first, const BigFloat& second) {
+    return !(first < second);
+}
@@ -1,103 +1,933 @@
-#include <istream>
-#include <string>
-#include <vector>
-
-class BigInteger {
-  private:
-    std::vector<long long> digits;
-    int base = 1e9;
-    int len = 9;
-    bool isNegative = false;
-    void normalize();
-
-  public:
-    BigInteger();
-    BigInteger(int x);
-    BigInteger(const std::string& s);
-
-    bool getNegative() const;
-    const std::vector<long long int>& getDigits();
-    const std::vector<long long int>& getDigits() const;
-    long long getBase() const;
-
-    BigInteger& operator+=(const BigInteger& second);
-    BigInteger& operator-=(const BigInteger& second);
-    BigInteger& operator*=(const BigInteger& second);
-    BigInteger& operator/=(const BigInteger& second);
-    BigInteger& operator%=(const BigInteger& second);
-    BigInteger& operator++();
-    BigInteger operator++(int);
-    BigInteger& operator--();
-    BigInteger operator--(int);
-    std::string toString() const;
-
-    explicit operator bool();
-
-    BigInteger& operator>>=(int x);
-};
-
-BigInteger operator+(const BigInteger& first, const BigInteger& second);
-BigInteger operator-(const BigInteger& first, const BigInteger& second);
-BigInteger operator-(const BigInteger& first);
-BigInteger operator*(BigInteger first, const BigInteger& second);
-BigInteger operator/(BigInteger first, const BigInteger& second);
-BigInteger operator%(BigInteger first, const BigInteger& second);
-
-bool operator==(const BigInteger& first, const BigInteger& second);
-bool operator!=(const BigInteger& first, const BigInteger& second);
-bool operator<(const BigInteger& first, const BigInteger& second);
-bool operator<=(const BigInteger& first, const BigInteger& second);
-bool operator>(const BigInteger& first, const BigInteger& second);
-bool operator>=(const BigInteger& first, const BigInteger& second);
-
-BigInteger operator""_bi(const char* value, size_t /*unused*/);
-BigInteger operator""_bi(unsigned long long value);
-
-std::istream& operator>>(std::istream& is, BigInteger& result);
-std::ostream& operator<<(std::ostream& os, const BigInteger& toprint);
-
-class Rational {
-  private:
-    BigInteger denominator;
-    BigInteger numerator;
-    bool isNegative = false;
-
-  public:
-    Rational();
-    Rational(long long first);
-    Rational(BigInteger first);
-    Rational(BigInteger first, BigInteger second);
-
-    const BigInteger& getNumerator() const;
-    const BigInteger& getDenominator() const;
-    bool getSign() const;
-
-    Rational& operator+=(const Rational& second);
-    Rational& operator-=(const Rational& second);
-    Rational& operator*=(const Rational& second);
-    Rational& operator/=(const Rational& second);
-    Rational& operator++();
-    Rational operator++(int);
-    Rational& operator--();
-    Rational operator--(int);
-
-    std::string toString() const;
-    std::string asDecimal(size_t precision);
-
-    explicit operator double();
-};
-
-void gcd(BigInteger& first, BigInteger& second);
-
-Rational operator+(const Rational& first, const Rational& second);
-Rational operator-(const Rational& first, const Rational& second);
-Rational operator-(const Rational& first);
-Rational operator*(Rational first, const Rational& second);
-Rational operator/(Rational first, const Rational& second);
-
-bool operator==(const Rational& first, const Rational& second);
-bool operator!=(const Rational& first, const Rational& second);
-bool operator<(const Rational& first, const Rational& second);
-bool operator<=(const Rational& first, const Rational& second);
-bool operator>(const Rational& first, const Rational& second);
-bool operator>=(const Rational& first, const Rational& second);
+#include <algorithm>
+#include <array>
+#include <compare>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Heap memory for limbs. allocate returns room for size limbs; deallocate
+// gets it back with the same size.
+struct LimbAllocator {
+    uint32_t* (*allocate)(size_t size);
+    void (*deallocate)(uint32_t* limbs, size_t size);
+};
+
+// Limb storage of BigInteger. Up to kInlineCapacity limbs live inside the
+// object, so values up to 64 bits never touch the heap; longer values spill
+// to a buffer from the installed LimbAllocator that grows geometrically.
+class LimbVector {
+  private:
+    static constexpr size_t kInlineCapacity = 2;
+    uint32_t* heap = nullptr;
+    size_t count = 0;
+    size_t reserved = kInlineCapacity;
+    uint32_t local[kInlineCapacity] = {};
+
+    void grow(size_t required);
+
+  public:
+    LimbVector();
+    LimbVector(std::initializer_list<uint32_t> values);
+    LimbVector(size_t size, uint32_t value);
+    LimbVector(const uint32_t* first, const uint32_t* last);
+    LimbVector(const LimbVector& other);
+    LimbVector(LimbVector&& other) noexcept;
+    LimbVector& operator=(const LimbVector& other);
+    LimbVector& operator=(LimbVector&& other) noexcept;
+    ~LimbVector();
+
+    size_t size() const;
+    bool empty() const;
+    size_t capacity() const;
+    uint32_t* data();
+    const uint32_t* data() const;
+    uint32_t* begin();
+    const uint32_t* begin() const;
+    uint32_t* end();
+    const uint32_t* end() const;
+    uint32_t& operator[](size_t index);
+    const uint32_t& operator[](size_t index) const;
+    uint32_t& back();
+    const uint32_t& back() const;
+
+    void reserve(size_t size);
+    void resize(size_t size, uint32_t value = 0);
+    void push_back(uint32_t value);
+    void pop_back();
+    void clear();
+    void assign(size_t size, uint32_t value);
+    void assign(const uint32_t* first, const uint32_t* last);
+    void insert(const uint32_t* position, size_t size, uint32_t value);
+};
+
+bool operator==(const LimbVector& first, const LimbVector& second);
+
+class BigInteger {
+  private:
+    // Magnitude in base 2^32, least significant limb first, without leading
+    // zero limbs. Zero is a single zero limb and is never negative.
+    LimbVector digits;
+    static constexpr long long base = 1LL << 32;
+    bool isNegative = false;
+    void normalize();
+
+    void mulAccumulate(const BigInteger& first, const BigInteger& second,
+                       bool subtract);
+    void applyBitwise(const BigInteger& second,
+                      uint32_t (*op)(uint32_t, uint32_t));
+
+    static const BigInteger& decimalPower(std::vector<BigInteger>& powers,
+                                          size_t k);
+    void parseChunks(const char* s, size_t size);
+    void assignDecimal(const char* s, size_t size, bool negative);
+    static BigInteger parseDecimal(const char* s, size_t size,
+                                   std::vector<BigInteger>& powers);
+    template <typename Sink>
+    static void writeDecimal(const BigInteger& value, size_t width,
+                             std::vector<BigInteger>& powers, Sink& sink);
+
+    static BigInteger limbRange(const BigInteger& value, size_t from,
+                                size_t to);
+    static BigInteger shiftedLimbs(const BigInteger& value, size_t count);
+    static void divmodSmall(const BigInteger& first, uint32_t second,
+                            BigInteger& quotient, BigInteger& remainder);
+    static void divmodLong(const BigInteger& first, const BigInteger& second,
+                           BigInteger& quotient, BigInteger& remainder);
+
+  public:
+    BigInteger();
+    BigInteger(long long x);
+    BigInteger(const std::string& s);
+
+    bool getNegative() const;
+    const LimbVector& getDigits();
+    const LimbVector& getDigits() const;
+    long long getBase() const;
+
+    BigInteger& operator+=(const BigInteger& second);
+    BigInteger& operator-=(const BigInteger& second);
+    BigInteger& operator*=(const BigInteger& second);
+    BigInteger& operator/=(const BigInteger& second);
+    BigInteger& operator%=(const BigInteger& second);
+    BigInteger& operator++();
+    BigInteger operator++(int);
+    BigInteger& operator--();
+    BigInteger operator--(int);
+
+    // In-place kernels: addMul/subMul add or subtract first * second without
+    // building the product, mulSmall multiplies by a single limb, square
+    // computes each cross product once (x * x and x *= x do the same).
+    BigInteger& addMul(const BigInteger& first, const BigInteger& second);
+    BigInteger& subMul(const BigInteger& first, const BigInteger& second);
+    BigInteger& mulSmall(uint32_t factor);
+    BigInteger& square();
+    BigInteger& negate();
+    BigInteger& abs();
+
+    std::string toString() const;
+    // Mixes the limbs two at a time; equal values hash equally.
+    size_t hash() const;
+
+    // The nearest double (ties to even), infinity when out of range.
+    double toDouble() const;
+    // The value rounded toward zero, 0 for infinities and NaN.
+    static BigInteger fromDouble(double value);
+
+    // Binary form: a LEB128 varint holding 2 * limbs + sign, then the limbs
+    // as 4-byte little-endian words; zero is the single byte 0.
+    size_t serializedSize() const;
+    // Writes the binary form to the front of out and returns its size, or
+    // returns 0 and writes nothing when out is too small.
+    size_t serialize(std::span<uint8_t> out) const;
+    // Reads the binary form at the front of in and returns its size, or
+    // returns 0 and leaves the value unchanged when there is no valid one.
+    size_t deserialize(std::span<const uint8_t> in);
+
+    explicit operator bool();
+
+    // Binary shifts of the two's complement value: >>= rounds toward
+    // negative infinity, so -1 >> 1 == -1.
+    BigInteger& operator<<=(size_t bits);
+    BigInteger& operator>>=(size_t bits);
+    // Bitwise operations on the infinite two's complement representations,
+    // as for built-in signed integers.
+    BigInteger& operator&=(const BigInteger& second);
+    BigInteger& operator|=(const BigInteger& second);
+    BigInteger& operator^=(const BigInteger& second);
+    // Number of bits of |value| (0 for zero) and how many of them are set.
+    size_t bitLength() const;
+    size_t popcount() const;
+
+    friend std::pair<BigInteger, BigInteger> divmod(const BigInteger& first,
+                                                    const BigInteger& second);
+    friend BigInteger greatestCommonDivisor(const BigInteger& first,
+                                            const BigInteger& second);
+    friend BigInteger divExact(const BigInteger& first,
+                               const BigInteger& second);
+    friend BigInteger isqrt(const BigInteger& value);
+    friend BigInteger iroot(const BigInteger& value, unsigned k);
+    friend bool isPerfectSquare(const BigInteger& value);
+    friend bool isPerfectPower(const BigInteger& value);
+    friend BigInteger operator""_bi(unsigned long long value);
+    friend std::istream& operator>>(std::istream& is, BigInteger& result);
+    friend std::ostream& operator<<(std::ostream& os,
+                                    const BigInteger& toPrint);
+    friend class MontgomeryContext;
+    friend class BigIntegerAccumulator;
+    friend class BigIntegerView;
+    template <size_t Bits>
+    friend class FixedBigInt;
+    friend class BarrettReducer;
+};
+
+// Truncated division: the quotient rounds toward zero and the remainder takes
+// the sign of the dividend, exactly as operator/ and operator% do.
+std::pair<BigInteger, BigInteger> divmod(const BigInteger& first,
+                                         const BigInteger& second);
+
+BigInteger operator+(BigInteger first, const BigInteger& second);
+BigInteger operator+(const BigInteger& first, BigInteger&& second);
+BigInteger operator-(BigInteger first, const BigInteger& second);
+BigInteger operator-(const BigInteger& first, BigInteger&& second);
+BigInteger operator-(BigInteger first);
+BigInteger operator*(BigInteger first, const BigInteger& second);
+BigInteger operator*(const BigInteger& first, BigInteger&& second);
+BigInteger operator/(BigInteger first, const BigInteger& second);
+BigInteger operator%(BigInteger first, const BigInteger& second);
+BigInteger operator<<(BigInteger value, size_t bits);
+BigInteger operator>>(BigInteger value, size_t bits);
+BigInteger operator&(BigInteger first, const BigInteger& second);
+BigInteger operator|(BigInteger first, const BigInteger& second);
+BigInteger operator^(BigInteger first, const BigInteger& second);
+
+// Non-negative gcd; greatestCommonDivisor(0, 0) == 0.
+BigInteger greatestCommonDivisor(const BigInteger& first,
+                                 const BigInteger& second);
+// first / second for a second known to divide first exactly.
+BigInteger divExact(const BigInteger& first, const BigInteger& second);
+
+// Products whose shorter operand has at least `limbs` limbs (1024 by
+// default) run their top Karatsuba levels on `threads` threads, the calling
+// one included. The default, and what 0 selects, is one thread per core; a
+// single thread keeps multiplication serial. Thresholds below the
+// Karatsuba cutoff (32 limbs) are raised to it.
+void setMultiplicationThreads(unsigned threads);
+void setParallelMultiplicationThreshold(size_t limbs);
+
+// Installs the allocator for the limbs of values longer than 64 bits and
+// returns the previous one; the default uses new[] and delete[]. Buffers
+// already allocated are freed by whichever allocator is installed at that
+// time, so a replacement installed once values exist must accept them (a
+// counting wrapper around the previous one does). Division, multiplication
+// and decimal conversion keep their temporaries on a per-thread scratch
+// stack and allocate only their results. Not synchronized: install it while
+// no other thread works on these types.
+LimbAllocator setLimbAllocator(LimbAllocator allocator);
+
+// Left-to-right square-and-multiply.
+BigInteger pow(const BigInteger& base, unsigned exponent);
+
+// Products are taken over a balanced tree, so every multiplication has
+// operands of similar size. factorial uses Luschny's prime swing,
+// n! = ((n / 2)!)^2 * swing(n), where the prime factorization of
+// swing(n) = n! / ((n / 2)!)^2 is read off directly; binomial multiplies
+// its factorization by Legendre's formula.
+BigInteger product(std::span<const BigInteger> factors);
+BigInteger factorial(unsigned n);
+// n! / (k! (n - k)!), 0 for k > n.
+BigInteger binomial(unsigned n, unsigned k);
+
+// floor(sqrt(value)) for value >= 0 (0 for negative values).
+BigInteger isqrt(const BigInteger& value);
+// The k-th root rounded toward zero; value must be non-negative for even k.
+// k == 0 throws std::invalid_argument.
+BigInteger iroot(const BigInteger& value, unsigned k);
+bool isPerfectSquare(const BigInteger& value);
+// Whether |value| = m^k for some integers m and k >= 2 (true for 0 and 1);
+// for negative values k must be odd.
+bool isPerfectPower(const BigInteger& value);
+
+// Baillie-PSW: trial division by the primes below 1024 (one single-limb
+// remainder per group of primes), a strong probable-prime test to base 2
+// and a strong Lucas test with Selfridge's parameters. No composite is
+// known to pass; below 2^64 the answer is exact. False for values < 2.
+bool isProbablePrime(const BigInteger& value);
+// isProbablePrime of every candidate, the candidates shared among the
+// multiplication threads.
+std::vector<bool> isProbablePrime(std::span<const BigInteger> candidates);
+// The primes in [from, from + length), ascending. The window is sieved in
+// segments by the primes below 2^16; survivors are exact primes when the
+// sieve reached the square root of the upper end and go through
+// isProbablePrime otherwise.
+std::vector<BigInteger> primesInRange(const BigInteger& from, size_t length);
+
+bool operator==(const BigInteger& first, const BigInteger& second);
+bool operator!=(const BigInteger& first, const BigInteger& second);
+bool operator<(const BigInteger& first, const BigInteger& second);
+bool operator<=(const BigInteger& first, const BigInteger& second);
+bool operator>(const BigInteger& first, const BigInteger& second);
+bool operator>=(const BigInteger& first, const BigInteger& second);
+
+BigInteger operator""_bi(const char* value, size_t /*unused*/);
+BigInteger operator""_bi(unsigned long long value);
+
+std::istream& operator>>(std::istream& is, BigInteger& result);
+std::ostream& operator<<(std::ostream& os, const BigInteger& toPrint);
+
+// Many values back to back in the binary form. serialize returns the bytes
+// written (0 when out is too small); deserialize fills every element of
+// values and returns the bytes read (0 when in is short or malformed).
+size_t serialize(std::span<const BigInteger> values, std::span<uint8_t> out);
+size_t deserialize(std::span<const uint8_t> in, std::span<BigInteger> values);
+
+// A serialized BigInteger read in place, e.g. from a mapped file: parse
+// checks the header and keeps a pointer to the limbs without copying them.
+// The buffer must outlive the view.
+class BigIntegerView {
+  private:
+    const uint8_t* limbs = nullptr;
+    size_t count = 0;
+    size_t encodedSize = 0;
+    bool isNegative = false;
+
+  public:
+    // The value at the front of in, or nothing when there is no valid one.
+    static std::optional<BigIntegerView> parse(std::span<const uint8_t> in);
+
+    bool getNegative() const;
+    // Number of limbs, 0 for zero.
+    size_t size() const;
+    uint32_t operator[](size_t index) const;
+    // Bytes taken by the value in the buffer, where the next one starts.
+    size_t serializedSize() const;
+    BigInteger toBigInteger() const;
+    // Copies the value into value, reusing its storage.
+    void assignTo(BigInteger& value) const;
+};
+
+// Modular arithmetic for a fixed odd modulus N > 1 in the Montgomery domain
+// (R = 2^(32 * limbs of N)). R mod N, R^2 mod N and -N^-1 mod 2^32 are
+// computed once; the sliding-window table and the multiplication scratch
+// are kept in the context and reused by every powmod call.
+class MontgomeryContext {
+  private:
+    LimbVector modulus;
+    LimbVector one;
+    LimbVector rSquared;
+    uint32_t inverse = 0;
+    std::vector<uint32_t> scratch;
+    std::vector<LimbVector> table;
+
+    void multiply(const uint32_t* first, const uint32_t* second,
+                  uint32_t* out);
+    LimbVector toResidue(const BigInteger& value);
+
+  public:
+    explicit MontgomeryContext(const BigInteger& modulus);
+
+    // base^exponent mod N for exponent >= 0, in [0, N).
+    BigInteger powmod(const BigInteger& base, const BigInteger& exponent);
+};
+
+// Barrett reduction by a fixed modulus m > 0: mu = floor(2^(64k) / m) is
+// precomputed, so reducing a value below m^2 costs two multiplications and
+// at most two subtractions instead of a division.
+class BarrettReducer {
+  private:
+    BigInteger modulus;
+    BigInteger mu;
+    size_t size;
+
+  public:
+    explicit BarrettReducer(const BigInteger& modulus);
+
+    // value mod m in [0, m); values outside [0, m^2) fall back to operator%.
+    BigInteger reduce(const BigInteger& value) const;
+    BigInteger multiply(const BigInteger& first,
+                        const BigInteger& second) const;
+};
+
+// base^exponent mod modulus for exponent >= 0 and modulus > 0, in
+// [0, modulus). Odd moduli use MontgomeryContext, even ones BarrettReducer.
+BigInteger powmod(const BigInteger& base, const BigInteger& exponent,
+                  const BigInteger& modulus);
+
+// Sums BigIntegers in carry-save form: every limb of a term is added to its
+// own 64-bit column (positive and negative terms in separate columns) with
+// no carry between columns, so an addition is a single pass that
+// vectorizes. A column gains less than 2^32 per term, which leaves room for
+// 2^32 - 1 terms; carries are propagated after carryPeriod terms (at most
+// that many), on normalize(), or when the value is read.
+class BigIntegerAccumulator {
+  private:
+    std::vector<uint64_t> positive;
+    std::vector<uint64_t> negative;
+    size_t carryPeriod;
+    size_t pending = 0;
+
+    void add(const BigInteger& term, bool subtract);
+    static void propagate(std::vector<uint64_t>& columns);
+    static BigInteger collect(std::vector<uint64_t> columns);
+
+  public:
+    static constexpr size_t kMaxCarryPeriod = 0xFFFFFFFF;
+
+    explicit BigIntegerAccumulator(size_t carryPeriod = kMaxCarryPeriod);
+
+    BigIntegerAccumulator& operator+=(const BigInteger& term);
+    BigIntegerAccumulator& operator-=(const BigInteger& term);
+
+    void normalize();
+    BigInteger value() const;
+};
+
+// Unsigned integer of Bits bits (a positive multiple of 32) with its limbs
+// stored inline and arithmetic modulo 2^Bits, like the built-in unsigned
+// types. Everything but the BigInteger conversions is constexpr, and the
+// add, subtract and multiply kernels are unrolled over the limbs at compile
+// time. Negative BigIntegers convert to their two's complement.
+template <size_t Bits>
+class FixedBigInt {
+    static_assert(Bits > 0 && Bits % 32 == 0,
+                  "Bits must be a positive multiple of 32");
+
+  public:
+    static constexpr size_t kLimbs = Bits / 32;
+
+  private:
+    // Least significant limb first.
+    std::array<uint32_t, kLimbs> limbs{};
+
+    // step(0), step(1), ..., step(kLimbs - 1) as one unrolled expression.
+    template <typename Step>
+    static constexpr void unrolled(Step step) {
+        [&step]<size_t... Index>(std::index_sequence<Index...>) {
+            (step(Index), ...);
+        }(std::make_index_sequence<kLimbs>());
+    }
+
+    // limbs = limbs * factor + addend, returns the limb carried out
+    constexpr uint32_t mulAddSmall(uint32_t factor, uint32_t addend) {
+        uint64_t carry = addend;
+        unrolled([this, factor, &carry](size_t i) {
+            carry += static_cast<uint64_t>(limbs[i]) * factor;
+            limbs[i] = static_cast<uint32_t>(carry);
+            carry >>= 32;
+        });
+        return static_cast<uint32_t>(carry);
+    }
+
+  public:
+    constexpr FixedBigInt() = default;
+
+    constexpr FixedBigInt(unsigned long long value) {
+        for (size_t i = 0; i < kLimbs && value != 0; ++i, value >>= 32) {
+            limbs[i] = static_cast<uint32_t>(value);
+        }
+    }
+
+    // Zero-extends or truncates a value of another width.
+    template <size_t OtherBits>
+    constexpr explicit FixedBigInt(const FixedBigInt<OtherBits>& other) {
+        for (size_t i = 0; i < std::min(kLimbs, other.kLimbs); ++i) {
+            limbs[i] = other.getLimbs()[i];
+        }
+    }
+
+    // value modulo 2^Bits.
+    explicit FixedBigInt(const BigInteger& value) {
+        const LimbVector& digits = value.getDigits();
+        for (size_t i = 0; i < std::min(kLimbs, digits.size()); ++i) {
+            limbs[i] = digits[i];
+        }
+        if (value.getNegative()) {
+            *this = -*this;
+        }
+    }
+
+    explicit operator BigInteger() const {
+        BigInteger answer;
+        answer.digits.assign(limbs.data(), limbs.data() + kLimbs);
+        answer.normalize();
+        return answer;
+    }
+
+    // Decimal, or hexadecimal, binary and octal with the C++ prefixes;
+    // digit separators are skipped. Empty when the text is not a number or
+    // the value needs more than Bits bits.
+    static constexpr std::optional<FixedBigInt> parse(std::string_view text) {
+        uint32_t radix = 10;
+        if (text.size() > 2 && text[0] == '0' &&
+            (text[1] == 'x' || text[1] == 'X' || text[1] == 'b' ||
+             text[1] == 'B')) {
+            radix = (text[1] == 'x' || text[1] == 'X') ? 16 : 2;
+            text.remove_prefix(2);
+        } else if (text.size() > 1 && text[0] == '0') {
+            radix = 8;
+        }
+        FixedBigInt answer;
+        bool empty = true;
+        for (char symbol : text) {
+            if (symbol == '\'') {
+                continue;
+            }
+            uint32_t digit = radix;
+            if (symbol >= '0' && symbol <= '9') {
+                digit = static_cast<uint32_t>(symbol - '0');
+            } else if (symbol >= 'a' && symbol <= 'f') {
+                digit = static_cast<uint32_t>(symbol - 'a' + 10);
+            } else if (symbol >= 'A' && symbol <= 'F') {
+                digit = static_cast<uint32_t>(symbol - 'A' + 10);
+            }
+            if (digit >= radix || answer.mulAddSmall(radix, digit) != 0) {
+                return std::nullopt;
+            }
+            empty = false;
+        }
+        if (empty) {
+            return std::nullopt;
+        }
+        return answer;
+    }
+
+    constexpr const std::array<uint32_t, kLimbs>& getLimbs() const {
+        return limbs;
+    }
+
+    std::string toString() const {
+        return static_cast<BigInteger>(*this).toString();
+    }
+
+    constexpr explicit operator bool() const {
+        return *this != FixedBigInt();
+    }
+
+    constexpr FixedBigInt& operator+=(const FixedBigInt& second) {
+        uint64_t carry = 0;
+        unrolled([this, &second, &carry](size_t i) {
+            carry += static_cast<uint64_t>(limbs[i]) + second.limbs[i];
+            limbs[i] = static_cast<uint32_t>(carry);
+            carry >>= 32;
+        });
+        return *this;
+    }
+
+    constexpr FixedBigInt& operator-=(const FixedBigInt& second) {
+        uint64_t borrow = 0;
+        unrolled([this, &second, &borrow](size_t i) {
+            uint64_t cur =
+                static_cast<uint64_t>(limbs[i]) - second.limbs[i] - borrow;
+            limbs[i] = static_cast<uint32_t>(cur);
+            borrow = cur >> 63;
+        });
+        return *this;
+    }
+
+    // Schoolbook product truncated to kLimbs limbs: row j only reaches
+    // limbs [j, kLimbs), about half of the full product.
+    constexpr FixedBigInt& operator*=(const FixedBigInt& second) {
+        std::array<uint32_t, kLimbs> product{};
+        unrolled([this, &second, &product](size_t j) {
+            uint64_t carry = 0;
+            uint64_t factor = second.limbs[j];
+            for (size_t i = 0; i + j < kLimbs; ++i) {
+                carry += limbs[i] * factor + product[i + j];
+                product[i + j] = static_cast<uint32_t>(carry);
+                carry >>= 32;
+            }
+        });
+        limbs = product;
+        return *this;
+    }
+
+    constexpr FixedBigInt& operator&=(const FixedBigInt& second) {
+        unrolled([this, &second](size_t i) { limbs[i] &= second.limbs[i]; });
+        return *this;
+    }
+
+    constexpr FixedBigInt& operator|=(const FixedBigInt& second) {
+        unrolled([this, &second](size_t i) { limbs[i] |= second.limbs[i]; });
+        return *this;
+    }
+
+    constexpr FixedBigInt& operator^=(const FixedBigInt& second) {
+        unrolled([this, &second](size_t i) { limbs[i] ^= second.limbs[i]; });
+        return *this;
+    }
+
+    constexpr FixedBigInt& operator<<=(size_t bits) {
+        size_t shift = std::min(bits / 32, kLimbs);
+        size_t offset = bits % 32;
+        for (size_t i = kLimbs; i-- > shift;) {
+            uint64_t cur = static_cast<uint64_t>(limbs[i - shift]) << 32;
+            if (i > shift) {
+                cur |= limbs[i - shift - 1];
+            }
+            limbs[i] = static_cast<uint32_t>(cur >> (32 - offset));
+        }
+        for (size_t i = 0; i < shift; ++i) {
+            limbs[i] = 0;
+        }
+        return *this;
+    }
+
+    constexpr FixedBigInt& operator>>=(size_t bits) {
+        size_t shift = std::min(bits / 32, kLimbs);
+        size_t offset = bits % 32;
+        for (size_t i = 0; i + shift < kLimbs; ++i) {
+            uint64_t cur = limbs[i + shift];
+            if (i + shift + 1 < kLimbs) {
+                cur |= static_cast<uint64_t>(limbs[i + shift + 1]) << 32;
+            }
+            limbs[i] = static_cast<uint32_t>(cur >> offset);
+        }
+        for (size_t i = kLimbs - shift; i < kLimbs; ++i) {
+            limbs[i] = 0;
+        }
+        return *this;
+    }
+
+    friend constexpr FixedBigInt operator+(FixedBigInt first,
+                                           const FixedBigInt& second) {
+        return first += second;
+    }
+
+    friend constexpr FixedBigInt operator-(FixedBigInt first,
+                                           const FixedBigInt& second) {
+        return first -= second;
+    }
+
+    friend constexpr FixedBigInt operator-(const FixedBigInt& value) {
+        return FixedBigInt() - value;
+    }
+
+    friend constexpr FixedBigInt operator*(FixedBigInt first,
+                                           const FixedBigInt& second) {
+        return first *= second;
+    }
+
+    friend constexpr FixedBigInt operator&(FixedBigInt first,
+                                           const FixedBigInt& second) {
+        return first &= second;
+    }
+
+    friend constexpr FixedBigInt operator|(FixedBigInt first,
+                                           const FixedBigInt& second) {
+        return first |= second;
+    }
+
+    friend constexpr FixedBigInt operator^(FixedBigInt first,
+                                           const FixedBigInt& second) {
+        return first ^= second;
+    }
+
+    friend constexpr FixedBigInt operator~(FixedBigInt value) {
+        unrolled([&value](size_t i) { value.limbs[i] = ~value.limbs[i]; });
+        return value;
+    }
+
+    friend constexpr FixedBigInt operator<<(FixedBigInt value, size_t bits) {
+        return value <<= bits;
+    }
+
+    friend constexpr FixedBigInt operator>>(FixedBigInt value, size_t bits) {
+        return value >>= bits;
+    }
+
+    friend constexpr bool operator==(const FixedBigInt& first,
+                                     const FixedBigInt& second) = default;
+
+    friend constexpr std::strong_ordering operator<=>(
+        const FixedBigInt& first, const FixedBigInt& second) {
+        for (size_t i = kLimbs; i-- > 0;) {
+            if (first.limbs[i] != second.limbs[i]) {
+                return first.limbs[i] <=> second.limbs[i];
+            }
+        }
+        return std::strong_ordering::equal;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os,
+                                    const FixedBigInt& value) {
+        return os << static_cast<BigInteger>(value);
+    }
+};
+
+// The literal as a FixedBigInt<Bits>, rejected at compile time when it does
+// not fit.
+template <size_t Bits, char... Digits>
+consteval FixedBigInt<Bits> fixedBigIntLiteral() {
+    constexpr std::array<char, sizeof...(Digits)> kText = {Digits...};
+    constexpr std::optional<FixedBigInt<Bits>> kValue =
+        FixedBigInt<Bits>::parse(std::string_view(kText.data(), kText.size()));
+    static_assert(kValue.has_value(), "integer literal does not fit");
+    return *kValue;
+}
+
+template <char... Digits>
+consteval FixedBigInt<128> operator""_u128() {
+    return fixedBigIntLiteral<128, Digits...>();
+}
+
+template <char... Digits>
+consteval FixedBigInt<256> operator""_u256() {
+    return fixedBigIntLiteral<256, Digits...>();
+}
+
+template <char... Digits>
+consteval FixedBigInt<512> operator""_u512() {
+    return fixedBigIntLiteral<512, Digits...>();
+}
+
+template <char... Digits>
+consteval FixedBigInt<1024> operator""_u1024() {
+    return fixedBigIntLiteral<1024, Digits...>();
+}
+
+class Rational {
+  private:
+    BigInteger denominator;
+    BigInteger numerator;
+    bool isNegative = false;
+
+    void normalize();
+    void accumulate(const Rational& second, bool subtract);
+    void multiply(const BigInteger& secondNumerator,
+                  const BigInteger& secondDenominator);
+    bool accumulateWords(const Rational& second, bool subtract);
+    bool multiplyWords(const BigInteger& secondNumerator,
+                       const BigInteger& secondDenominator);
+    void appendFraction(std::string& out, BigInteger remainder,
+                        size_t precision) const;
+
+  public:
+    Rational();
+    Rational(long long first);
+    Rational(BigInteger first);
+    Rational(BigInteger first, BigInteger second);
+
+    const BigInteger& getNumerator() const;
+    const BigInteger& getDenominator() const;
+    bool getSign() const;
+    size_t hash() const;
+
+    Rational& operator+=(const Rational& second);
+    Rational& operator-=(const Rational& second);
+    Rational& operator*=(const Rational& second);
+    Rational& operator/=(const Rational& second);
+    Rational& operator++();
+    Rational operator++(int);
+    Rational& operator--();
+    Rational operator--(int);
+
+    std::string toString() const;
+    // The value with precision digits after the point, truncated toward
+    // zero, and no sign if every digit is 0; appendDecimal writes the same
+    // text to the end of out.
+    std::string asDecimal(size_t precision) const;
+    void appendDecimal(std::string& out, size_t precision) const;
+
+    // The nearest double (ties to even), computed from a 64-bit quotient.
+    double toDouble() const;
+    // The exact value of a finite double, 0 for infinities and NaN.
+    static Rational fromDouble(double value);
+
+    explicit operator double() const;
+
+    // The numerator's binary form (with the sign), then the denominator's.
+    // deserialize rejects a fraction not in lowest terms with a positive
+    // denominator (2/4, 0/5, 1/-2), as serialize never writes one.
+    size_t serializedSize() const;
+    size_t serialize(std::span<uint8_t> out) const;
+    size_t deserialize(std::span<const uint8_t> in);
+};
+
+// Sums Rationals without reducing after every term: fractions are added
+// over the product of denominators (or directly when the denominators
+// match) and reduced only once the numerator or denominator grows past a
+// limb threshold, on normalize(), or when the value is read. The value read
+// back is always the fully reduced Rational an eager sum would produce.
+class RationalAccumulator {
+  private:
+    BigInteger numerator;
+    BigInteger denominator = 1;
+    size_t reductionLimbs;
+    size_t nextReduction;
+
+    void add(const Rational& term, bool subtract);
+
+  public:
+    static constexpr size_t kDefaultReductionLimbs = 64;
+
+    explicit RationalAccumulator(
+        size_t reductionLimbs = kDefaultReductionLimbs);
+    explicit RationalAccumulator(
+        const Rational& initial,
+        size_t reductionLimbs = kDefaultReductionLimbs);
+
+    RationalAccumulator& operator+=(const Rational& term);
+    RationalAccumulator& operator-=(const Rational& term);
+
+    void normalize();
+    Rational value() const;
+    std::string toString() const;
+};
+
+bool operator==(const RationalAccumulator& first, const Rational& second);
+bool operator!=(const RationalAccumulator& first, const Rational& second);
+bool operator<(const RationalAccumulator& first, const Rational& second);
+bool operator>(const RationalAccumulator& first, const Rational& second);
+bool operator<=(const RationalAccumulator& first, const Rational& second);
+bool operator>=(const RationalAccumulator& first, const Rational& second);
+
+void gcd(BigInteger& first, BigInteger& second);
+
+Rational operator+(const Rational& first, const Rational& second);
+Rational operator-(const Rational& first, const Rational& second);
+Rational operator-(const Rational& first);
+Rational operator*(Rational first, const Rational& second);
+Rational operator/(Rational first, const Rational& second);
+
+bool operator==(const Rational& first, const Rational& second);
+bool operator!=(const Rational& first, const Rational& second);
+bool operator<(const Rational& first, const Rational& second);
+bool operator<=(const Rational& first, const Rational& second);
+bool operator>(const Rational& first, const Rational& second);
+bool operator>=(const Rational& first, const Rational& second);
+
+// A dense matrix of BigIntegers stored row by row. determinant, rank and
+// solve use Bareiss' fraction-free elimination, whose intermediate entries
+// are minors of the matrix: they grow linearly and no gcd is ever taken.
+// The row updates of large elimination steps run on the multiplication
+// thread pool (see setMultiplicationThreads).
+class BigIntegerMatrix {
+  private:
+    size_t rowCount = 0;
+    size_t columnCount = 0;
+    std::vector<BigInteger> entries;
+
+  public:
+    BigIntegerMatrix() = default;
+    BigIntegerMatrix(size_t rows, size_t columns);
+    // Rows of different lengths throw std::invalid_argument.
+    BigIntegerMatrix(
+        std::initializer_list<std::initializer_list<BigInteger>> rows);
+
+    size_t rows() const;
+    size_t columns() const;
+    BigInteger& operator()(size_t row, size_t column);
+    const BigInteger& operator()(size_t row, size_t column) const;
+
+    // determinant and modularDeterminant require a square matrix.
+    BigInteger determinant() const;
+    // The determinant from its residues modulo 31-bit primes, one prime
+    // per thread, joined by the Chinese remainder theorem once the primes
+    // cover twice the Hadamard bound. For large matrices of small entries
+    // it does word arithmetic where determinant() multiplies minors.
+    BigInteger modularDeterminant() const;
+    size_t rank() const;
+    // The x with (*this) * x == rhs, nullopt for a singular matrix.
+    // Requires a square matrix and rhs.size() == rows().
+    std::optional<std::vector<Rational>> solve(
+        std::span<const BigInteger> rhs) const;
+};
+
+// Solves matrix * x == rhs for a square Rational matrix: each equation is
+// scaled by the lcm of its denominators and passed to
+// BigIntegerMatrix::solve. nullopt for a singular matrix.
+std::optional<std::vector<Rational>> solve(
+    const std::vector<std::vector<Rational>>& matrix,
+    const std::vector<Rational>& rhs);
+
+// A binary floating-point number mantissa * 2^exponent whose mantissa has
+// at most precision bits. Every operation is correctly rounded (to nearest,
+// ties to even) to the larger precision of its operands, so iterations run
+// in bounded memory. Integers convert exactly, with kDefaultPrecision bits
+// or as many as they need; Rationals and decimal text are rounded to the
+// precision given. The mantissa is kept odd (or zero), so equal values
+// have equal fields.
+class BigFloat {
+  private:
+    BigInteger mantissa;
+    int64_t exponent = 0;
+    size_t precision = kDefaultPrecision;
+
+    void round();
+    void add(const BigFloat& second, bool subtract);
+    void assignQuotient(BigInteger dividend, const BigInteger& divisor,
+                        int64_t scale);
+
+  public:
+    static constexpr size_t kDefaultPrecision = 64;
+
+    BigFloat() = default;
+    BigFloat(long long value);
+    BigFloat(const BigInteger& value);
+    BigFloat(const BigInteger& value, size_t precision);
+    BigFloat(const Rational& value, size_t precision);
+    // Decimal text such as "-12.5", "3e-7" or "1.25E+300". Anything else
+    // throws std::invalid_argument, and a power of ten past the range of
+    // unsigned std::out_of_range. The string
+    // overloads are exact matches, so they are not taken for a BigInteger.
+    BigFloat(std::string_view text, size_t precision);
+    BigFloat(const char* text, size_t precision);
+    BigFloat(const std::string& text, size_t precision);
+
+    const BigInteger& getMantissa() const;
+    int64_t getExponent() const;
+    size_t getPrecision() const;
+    // Rounds the value to the new precision.
+    BigFloat& setPrecision(size_t bits);
+
+    BigFloat& operator+=(const BigFloat& second);
+    BigFloat& operator-=(const BigFloat& second);
+    BigFloat& operator*=(const BigFloat& second);
+    BigFloat& operator/=(const BigFloat& second);
+
+    // The exact value.
+    Rational toRational() const;
+    // Like Rational::asDecimal: precision digits after the point, truncated
+    // toward zero.
+    std::string asDecimal(size_t precision) const;
+
+    // The correctly rounded square root at the value's precision, 0 for
+    // negative values.
+    friend BigFloat sqrt(const BigFloat& value);
+};
+
+BigFloat sqrt(const BigFloat& value);
+
+BigFloat operator+(const BigFloat& first, const BigFloat& second);
+BigFloat operator-(const BigFloat& first, const BigFloat& second);
+BigFloat operator-(const BigFloat& value);
+BigFloat operator*(const BigFloat& first, const BigFloat& second);
+BigFloat operator/(const BigFloat& first, const BigFloat& second);
+
+bool operator==(const BigFloat& first, const BigFloat& second);
+bool operator!=(const BigFloat& first, const BigFloat& second);
+bool operator<(const BigFloat& first, const BigFloat& second);
+bool operator<=(const BigFloat& first, const BigFloat& second);
+bool operator>(const BigFloat& first, const BigFloat& second);
+bool operator>=(const BigFloat& first, const BigFloat& second);
+
+template <>
+struct std::hash<BigInteger> {
+    size_t operator()(const BigInteger& value) const {
+        return value.hash();
+    }
+};
+
+template <>
+struct std::hash<Rational> {
+    size_t operator()(const Rational& value) const {
+        return value.hash();
+    }
+};
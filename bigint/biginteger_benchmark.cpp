@@ -0,0 +1,28 @@
+#include "biginteger.h"
+
+#include <cassert>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+// Times one product of two ~1M-digit numbers for 1 to 32 threads.
+int main() {
+    const BigInteger first = pow(3_bi, 2'100'000);
+    const BigInteger second = pow(7_bi, 1'200'000);
+    setParallelMultiplicationThreshold(1024);
+    double serial = 0;
+    for (unsigned threads = 1; threads <= 32; threads *= 2) {
+        setMultiplicationThreads(threads);
+        auto start = std::chrono::steady_clock::now();
+        BigInteger product = first * second;
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+        assert(product.getDigits().size() >= first.getDigits().size());
+        if (threads == 1) {
+            serial = elapsed.count();
+        }
+        std::cout << std::setw(2) << threads << " threads: " << std::fixed
+                  << std::setprecision(3) << elapsed.count() << " s, x"
+                  << std::setprecision(2) << serial / elapsed.count() << '\n';
+    }
+}
@@ -1,104 +1,962 @@
-#include "biginteger.h"
-
-#include <cassert>
-#include <iostream>
-
-void test1() {
-    BigInteger from_empty;
-
-    BigInteger from_int(123'456);
-    BigInteger from_neg_int(-123'456);
-
-    BigInteger from_string("12345678901234567890");
-    BigInteger from_neg_string("-123123123123123123123123132132132131231");
-
-    BigInteger copy_constr(from_string);
-}
-
-void test2() {
-    assert(BigInteger("123456789123456789") ==
-           BigInteger("123456789123456789"));
-    assert(BigInteger("-12345678901234567890") ==
-           BigInteger("-12345678901234567890"));
-    assert(BigInteger("123456789123456789") != BigInteger("58943759834759"));
-}
-
-void test3() {
-    assert(BigInteger(1) < BigInteger(10));
-    assert(BigInteger(-100) < 5);
-    assert(!(BigInteger(1) > BigInteger(10)));
-    assert(!(BigInteger(-100) > BigInteger(5)));
-    assert(BigInteger("123456789012345678901234567890") <
-           BigInteger("123456789012545678901234567890"));
-    assert(!(BigInteger("123456789012345678901234567890") <
-             BigInteger("123456789012345678901234567890")));
-}
-
-void test4() {
-    {
-        BigInteger a("-1234567890123456789");
-        BigInteger b("1234567890123456789");
-
-        assert((a * b).toString() == "-1524157875323883675019051998750190521");
-    }
-
-    {
-        BigInteger a(
-            "12345123456789012345678923456789123534645723452363465473643423");
-        BigInteger b("12568432423758325345984738557347237543");
-
-        assert((a / b).toString() == "982232552203790490610772");
-    }
-
-    {
-        BigInteger a(
-            "12345123456789012345678923456789123534645723452363465473643423");
-        BigInteger b("12568432423758325345984738557347237543");
-
-        assert((a % b).toString() == "7378391778761293146339181012435030227");
-    }
-}
-
-void test5() {
-    if (BigInteger(0)) {
-        assert(false);
-    }
-    bool called = false;
-    if (BigInteger(1)) {
-        called = true;
-    }
-    assert(called);
-}
-
-void test6() {
-    Rational pi = 0;
-    Rational sign = 1;
-
-    for (BigInteger n = 1; n < 100; ++n) {
-        pi += sign * (Rational(4) / (Rational(2) * n - Rational(1)));
-        sign = -sign;
-    }
-
-    std::cerr << static_cast<double>(pi) << std::endl;
-    assert(std::abs(static_cast<double>(pi) - 3.14) < 0.1);
-    assert(Rational(3) < pi);
-    assert(pi < Rational(4));
-    assert(Rational(1) / Rational(2) ==
-           Rational("100000000000000000000000000000"_bi) /
-               Rational("200000000000000000000000000000"_bi));
-}
-
-int main() {
-    test1();
-    std::cerr << "Test 1 passed." << std::endl;
-    test2();
-    std::cerr << "Test 2 passed." << std::endl;
-    test3();
-    std::cerr << "Test 3 passed." << std::endl;
-    test4();
-    std::cerr << "Test 4 passed." << std::endl;
-    test5();
-    std::cerr << "Test 5 passed." << std::endl;
-    test6();
-    std::cerr << "Test 6 passed." << std::endl;
-}
+#include "biginteger.h"
+
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+void test1() {
+    BigInteger from_empty;
+
+    BigInteger from_int(123'456);
+    BigInteger from_neg_int(-123'456);
+
+    BigInteger from_string("12345678901234567890");
+    BigInteger from_neg_string("-123123123123123123123123132132132131231");
+
+    BigInteger copy_constr(from_string);
+}
+
+void test2() {
+    assert(BigInteger("123456789123456789") ==
+           BigInteger("123456789123456789"));
+    assert(BigInteger("-12345678901234567890") ==
+           BigInteger("-12345678901234567890"));
+    assert(BigInteger("123456789123456789") != BigInteger("58943759834759"));
+}
+
+void test3() {
+    assert(BigInteger(1) < BigInteger(10));
+    assert(BigInteger(-100) < 5);
+    assert(!(BigInteger(1) > BigInteger(10)));
+    assert(!(BigInteger(-100) > BigInteger(5)));
+    assert(BigInteger("123456789012345678901234567890") <
+           BigInteger("123456789012545678901234567890"));
+    assert(!(BigInteger("123456789012345678901234567890") <
+             BigInteger("123456789012345678901234567890")));
+}
+
+void test4() {
+    {
+        BigInteger a("-1234567890123456789");
+        BigInteger b("1234567890123456789");
+
+        assert((a * b).toString() == "-1524157875323883675019051998750190521");
+    }
+
+    {
+        BigInteger a(
+            "12345123456789012345678923456789123534645723452363465473643423");
+        BigInteger b("12568432423758325345984738557347237543");
+
+        assert((a / b).toString() == "982232552203790490610772");
+    }
+
+    {
+        BigInteger a(
+            "12345123456789012345678923456789123534645723452363465473643423");
+        BigInteger b("12568432423758325345984738557347237543");
+
+        assert((a % b).toString() == "7378391778761293146339181012435030227");
+    }
+}
+
+void test5() {
+    if (BigInteger(0)) {
+        assert(false);
+    }
+    bool called = false;
+    if (BigInteger(1)) {
+        called = true;
+    }
+    assert(called);
+}
+
+void test6() {
+    Rational pi = 0;
+    Rational sign = 1;
+
+    for (BigInteger n = 1; n < 100; ++n) {
+        pi += sign * (Rational(4) / (Rational(2) * n - Rational(1)));
+        sign = -sign;
+    }
+
+    std::cerr << static_cast<double>(pi) << std::endl;
+    assert(std::abs(static_cast<double>(pi) - 3.14) < 0.1);
+    assert(Rational(3) < pi);
+    assert(pi < Rational(4));
+    assert(Rational(1) / Rational(2) ==
+           Rational("100000000000000000000000000000"_bi) /
+               Rational("200000000000000000000000000000"_bi));
+}
+
+void test7() {
+    BigInteger a(
+        "12345123456789012345678923456789123534645723452363465473643423");
+    BigInteger b("-12568432423758325345984738557347237543");
+
+    auto [quotient, remainder] = divmod(a, b);
+    assert(quotient.toString() == "-982232552203790490610772");
+    assert(remainder.toString() == "7378391778761293146339181012435030227");
+    assert(quotient * b + remainder == a);
+
+    assert((a / 7).toString() ==
+           "1763589065255573192239846208112731933520817636051923639091917");
+    assert((-a % 1000).toString() == "-423");
+}
+
+void test8() {
+    BigInteger a("18446744073709551615");
+    ++a;
+    assert(a.toString() == "18446744073709551616");
+    assert((a - 1).toString() == "18446744073709551615");
+    assert(BigInteger(-4'294'967'296LL).toString() == "-4294967296");
+    assert(18'446'744'073'709'551'615_bi == a - 1);
+    assert(BigInteger(-5) != BigInteger(5));
+    assert(BigInteger(-7) < BigInteger(-5));
+    assert((a - a).toString() == "0");
+}
+
+void test9() {
+    std::string digits(5000, '0');
+    for (size_t i = 0; i < digits.size(); ++i) {
+        digits[i] = static_cast<char>('1' + i * 7 % 9);
+    }
+    BigInteger a(digits);
+    assert(a.toString() == digits);
+    assert((-a).toString() == '-' + digits);
+
+    std::ostringstream os;
+    os << a << ' ' << BigInteger(-42);
+    assert(os.str() == digits + " -42");
+
+    BigInteger power = 1;
+    for (int i = 0; i < 1000; ++i) {
+        power *= 10;
+    }
+    assert(power.toString() == '1' + std::string(1000, '0'));
+}
+
+void test10() {
+    BigInteger small(-1'234'567'890'123LL);
+    assert(small.getDigits().size() == 2);
+    assert(small.getDigits().capacity() == 2);
+
+    BigInteger grown = small;
+    grown *= small;
+    assert(grown.getDigits().size() == 3);
+    assert(grown.toString() == "1524157875322755800955129");
+
+    BigInteger moved = std::move(grown);
+    assert(moved.toString() == "1524157875322755800955129");
+    moved /= small;
+    moved /= small;
+    assert(moved == 1);
+}
+
+void test11() {
+    BigInteger a("123456789012345678901234567890");
+    BigInteger b("-987654321098765432109876543210");
+
+    BigInteger sum(5);
+    sum.addMul(a, b);
+    assert(sum == 5 + a * b);
+    sum.subMul(a, b);
+    assert(sum == 5);
+    sum.subMul(a, a);
+    assert(sum == 5 - a * a);
+
+    BigInteger c = b;
+    c.negate();
+    assert(c == -b);
+    c.abs();
+    assert(c == -b);
+    b.abs();
+    assert(c == b);
+    c.mulSmall(4'000'000'000U);
+    assert(c == b * 4'000'000'000LL);
+    assert((BigInteger(0).negate()).toString() == "0");
+
+    BigInteger carried("-14464251828804239820");
+    carried.subMul(2886065612, 1391553753);
+    assert(carried == BigInteger("-18480367262587081656"));
+    carried.addMul(-2886065612, 1391553753);
+    assert(carried == BigInteger("-22496482696369923492"));
+}
+
+void test12() {
+    BigInteger a("123456789012345678901234567890");
+    BigInteger b("987654321098765432109876543210");
+    assert(greatestCommonDivisor(a, b).toString() == "9000000000900000000090");
+    assert(greatestCommonDivisor(-a, 0) == a);
+    assert(divExact(a * b, -b) == -a);
+
+    Rational half(BigInteger(-3), BigInteger(-6));
+    assert(half.toString() == "1/2");
+    assert((Rational(BigInteger(3), BigInteger(-6))).toString() == "-1/2");
+    assert(Rational(1) / Rational(6) + Rational(1) / Rational(10) ==
+           Rational(BigInteger(4), BigInteger(15)));
+    assert((Rational(1) / Rational(6) - Rational(2) / Rational(3)).toString() ==
+           "-1/2");
+    assert(half != -half);
+    Rational x = -half;
+    ++x;
+    assert(x == half);
+}
+
+void test13() {
+    Rational eager = 0;
+    RationalAccumulator lazy(4);
+    for (int n = 1; n <= 200; ++n) {
+        Rational term = Rational(1) / Rational(n);
+        if (n % 3 == 0) {
+            eager -= term;
+            lazy -= term;
+        } else {
+            eager += term;
+            lazy += term;
+        }
+    }
+    assert(lazy == eager);
+    assert(lazy <= eager && lazy >= eager && !(lazy < eager));
+    assert(lazy < eager + 1 && lazy <= eager + 1 && !(lazy >= eager + 1));
+    assert(lazy > eager - 1 && lazy >= eager - 1 && !(lazy <= eager - 1));
+    assert(lazy.toString() == eager.toString());
+    lazy.normalize();
+    assert(lazy.value() == eager);
+
+    RationalAccumulator cancel(Rational(1) / Rational(3));
+    cancel -= Rational(1) / Rational(3);
+    assert(cancel.toString() == "0");
+}
+
+void test14() {
+    assert(powmod(3, "100000000000000000007"_bi, 1'000'000'007) == 914'238'817);
+    BigInteger power = "1267650600228229401496703205376"_bi;
+    assert(powmod(123'456'789, 987'654'321, power).toString() ==
+           "203118105120638269398627100245");
+    assert(powmod(-5, 3, 97) == 69);
+    assert(powmod(7, 0, 13) == 1);
+
+    MontgomeryContext context(1'000'000'007);
+    assert(context.powmod(2, 1'000'000'006) == 1);
+    assert(context.powmod(3, "100000000000000000007"_bi) == 914'238'817);
+
+    BarrettReducer reducer(1'000'000'007);
+    assert(reducer.reduce(BigInteger(999'999'999) * 999'999'999) ==
+           BigInteger(999'999'999) * 999'999'999 % 1'000'000'007);
+    assert(reducer.reduce(-1) == 1'000'000'006);
+}
+
+void test15() {
+    BigInteger square = "1000000000000000000000000000000"_bi;
+    assert(isqrt(square) == 1'000'000'000'000'000);
+    assert(isqrt(square - 1) == 999'999'999'999'999);
+    assert(isqrt(3) == 1);
+    assert(iroot(pow(123'456'789_bi, 7), 7) == 123'456'789);
+    assert(iroot(pow(123'456'789_bi, 7) - 1, 7) == 123'456'788);
+    assert(iroot(-1'000'000'000, 3) == -1000);
+    for (const BigInteger& value : {0_bi, 1_bi, 2_bi, -5_bi}) {
+        bool thrown = false;
+        try {
+            static_cast<void>(iroot(value, 0));
+        } catch (const std::invalid_argument&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+    assert(isPerfectSquare(square));
+    assert(!isPerfectSquare(square + 1));
+    assert(!isPerfectSquare(-4));
+    assert(isPerfectPower(pow(3_bi, 40)));
+    assert(isPerfectPower(-pow(10_bi, 21)));
+    assert(!isPerfectPower(-pow(10_bi, 20) * 10 + 1));
+    assert(!isPerfectPower(pow(2_bi, 64) * 3));
+}
+
+void test16() {
+    BigInteger first = pow(3_bi, 40'000);
+    BigInteger second = pow(7_bi, 25'000) + 1;
+    setMultiplicationThreads(1);
+    BigInteger serial = first * second;
+    setParallelMultiplicationThreshold(64);
+    for (unsigned threads : {2, 3, 8}) {
+        setMultiplicationThreads(threads);
+        assert(first * second == serial);
+        assert(second * (first * first) == serial * first);
+    }
+    // Thresholds below the Karatsuba one are raised to it, so small
+    // operands are not split into ever smaller pool tasks.
+    setMultiplicationThreads(4);
+    setParallelMultiplicationThreshold(1);
+    assert(BigInteger(5) * 7 == 35);
+    BigInteger small = (1_bi << 100) + 3;
+    assert(small * small == (1_bi << 200) + (3_bi << 101) + 9);
+    assert(first * 3 * second == serial * 3);
+    setMultiplicationThreads(0);
+    setParallelMultiplicationThreshold(1024);
+}
+
+void test17() {
+    BigInteger value = "123456789012345678901234567890"_bi;
+    assert((value << 70) == value * pow(2_bi, 70));
+    assert((value << 70 >> 70) == value);
+    assert((value >> 40) == value / pow(2_bi, 40));
+    assert((-value >> 40) == -(value / pow(2_bi, 40)) - 1);
+    assert((BigInteger(-1) >> 100) == -1);
+    assert((BigInteger(-8) >> 3) == -1);
+    assert(value.bitLength() == 97);
+    assert(BigInteger(0).bitLength() == 0);
+    assert(BigInteger(-255).popcount() == 8);
+
+    assert((BigInteger(12) & 10) == 8);
+    assert((BigInteger(12) | 10) == 14);
+    assert((BigInteger(12) ^ 10) == 6);
+    assert((BigInteger(-12) & 10) == 0);
+    assert((BigInteger(-12) | 10) == -2);
+    assert((BigInteger(-12) ^ -10) == 2);
+    assert((-(BigInteger(1) << 64) & ((BigInteger(1) << 70) - 1)) ==
+           (BigInteger(63) << 64));
+}
+
+void test18() {
+    assert(BigInteger(0).toDouble() == 0);
+    assert(BigInteger(-12345).toDouble() == -12345.0);
+    assert((BigInteger(1) << 1000).toDouble() == std::ldexp(1.0, 1000));
+    assert(((BigInteger(1) << 53) + 1).toDouble() == std::ldexp(1.0, 53));
+    assert(((BigInteger(1) << 53) + 3).toDouble() == std::ldexp(1.0, 53) + 4);
+    assert(std::isinf((BigInteger(1) << 1024).toDouble()));
+    assert(Rational(1, 3).toDouble() == 1.0 / 3);
+    assert(Rational(-22, 7).toDouble() == -22.0 / 7);
+    assert(Rational(1, BigInteger(1) << 1074).toDouble() ==
+           std::numeric_limits<double>::denorm_min());
+
+    assert(BigInteger::fromDouble(-2.75) == -2);
+    assert(BigInteger::fromDouble(1e30) ==
+           "1000000000000000019884624838656"_bi);
+    assert(Rational::fromDouble(0.375) == Rational(3, 8));
+    assert(Rational::fromDouble(-1e-300).toDouble() == -1e-300);
+}
+
+void test19() {
+    assert(Rational(22, 7).asDecimal(20) == "3.14285714285714285714");
+    assert(Rational(-1, 8).asDecimal(5) == "-0.12500");
+    assert(Rational(0).asDecimal(3) == "0.000");
+    assert(Rational(7, 2).asDecimal(0) == "3");
+    // Only a nonzero printed digit carries the sign.
+    assert(Rational(-1, 3).asDecimal(0) == "0");
+    assert(Rational(-1, 3000).asDecimal(3) == "0.000");
+    assert(Rational(-1, 3000).asDecimal(4) == "-0.0003");
+    assert(Rational(-7, 2).asDecimal(0) == "-3");
+    std::string appended = "x=";
+    Rational(-1, 3).appendDecimal(appended, 2);
+    assert(appended == "x=-0.33");
+    appended = "-";
+    Rational(-1, 7).appendDecimal(appended, 0);
+    assert(appended == "-0");
+    Rational third(1, "3000000000000000000000"_bi);
+    assert(third.asDecimal(25) == "0.0000000000000000000003333");
+
+    std::string out = "x = ";
+    Rational(2, 3).appendDecimal(out, 1000);
+    assert(out.size() == 4 + 2 + 1000);
+    assert(out.substr(0, 8) == "x = 0.66" && out.back() == '6');
+}
+
+void test20() {
+    constexpr FixedBigInt<128> kMax =
+        0xFFFFFFFF'FFFFFFFF'FFFFFFFF'FFFFFFFF_u128;
+    static_assert(kMax + 1 == 0);
+    static_assert(-1_u128 == kMax);
+    static_assert((3_u256 << 200) >> 199 == 6);
+    static_assert(1'000'000'007_u256 * 1'000'000'009_u256 ==
+                  1'000'000'016'000'000'063_u256);
+    static_assert(!FixedBigInt<64>::parse("18446744073709551616"));
+
+    BigInteger big = "123456789012345678901234567890123456789"_bi;
+    FixedBigInt<256> fixed(big);
+    assert(static_cast<BigInteger>(fixed * fixed) ==
+           big * big % (BigInteger(1) << 256));
+    assert(static_cast<BigInteger>(FixedBigInt<128>(-big)) ==
+           (BigInteger(1) << 128) - big);
+    assert(FixedBigInt<64>(fixed).toString() ==
+           (big & ((BigInteger(1) << 64) - 1)).toString());
+}
+
+void test21() {
+    BigInteger ones = (BigInteger(1) << 320) - 1;
+    BigIntegerAccumulator sum;
+    BigIntegerAccumulator often(3);
+    for (int i = 0; i < 1000; ++i) {
+        sum += ones;
+        often += ones;
+        sum -= i;
+        often -= i;
+    }
+    BigInteger expected = ones * 1000 - 999 * 1000 / 2;
+    assert(sum.value() == expected);
+    assert(often.value() == expected);
+    sum.normalize();
+    sum -= expected + 1;
+    assert(sum.value() == -1);
+    assert(BigIntegerAccumulator().value() == 0);
+}
+
+void test22() {
+    assert(factorial(0) == 1);
+    assert(factorial(20) == 2'432'902'008'176'640'000);
+    assert(factorial(30).toString() == "265252859812191058636308480000000");
+    BigInteger slow = 1;
+    for (int i = 2; i <= 1000; ++i) {
+        slow.mulSmall(i);
+    }
+    assert(factorial(1000) == slow);
+
+    assert(binomial(10, 3) == 120);
+    assert(binomial(5, 7) == 0);
+    assert(binomial(100, 50).toString() ==
+           "100891344545564193334812497256");
+    assert(binomial(1000, 500) * factorial(500) * factorial(500) == slow);
+
+    std::vector<BigInteger> factors = {3, -5, "123456789012345678901"_bi, 7};
+    assert(product(factors) == "-12962962846296296284605"_bi);
+    assert(product({}) == 1);
+}
+
+void test23() {
+    std::vector<uint8_t> buffer(64);
+    assert(BigInteger(0).serialize(buffer) == 1 && buffer[0] == 0);
+    assert(BigInteger(-1).serialize(buffer) == 5);
+    assert(buffer[0] == 3 && buffer[1] == 1 && buffer[4] == 0);
+
+    std::vector<BigInteger> values = {
+        0, -1, "-123456789012345678901234567890"_bi, BigInteger(1) << 100};
+    size_t written = serialize(values, buffer);
+    assert(written == 1 + 5 + 17 + 17);
+    std::vector<BigInteger> back(values.size());
+    assert(deserialize(std::span(buffer).first(written), back) == written);
+    assert(back == values);
+    assert(deserialize(std::span(buffer).first(written - 1), back) == 0);
+    assert(serialize(values, std::span(buffer).first(written - 1)) == 0);
+
+    std::optional<BigIntegerView> view =
+        BigIntegerView::parse(std::span(buffer).subspan(6));
+    assert(view && view->getNegative() && view->size() == 4);
+    assert(view->serializedSize() == 17 && view->toBigInteger() == values[2]);
+
+    Rational fraction(-22, 7);
+    assert(fraction.serialize(buffer) == 10);
+    Rational read;
+    assert(read.deserialize(buffer) == 10 && read == fraction);
+    const uint8_t negativeZero[] = {1};
+    assert(read.deserialize(negativeZero) == 0 && read == fraction);
+    const uint8_t twoFourths[] = {2, 2, 0, 0, 0, 2, 4, 0, 0, 0};
+    const uint8_t zeroFifths[] = {0, 2, 5, 0, 0, 0};
+    const uint8_t negativeZeroOne[] = {1, 2, 1, 0, 0, 0};
+    assert(read.deserialize(twoFourths) == 0 && read == fraction);
+    assert(read.deserialize(zeroFifths) == 0 && read == fraction);
+    assert(read.deserialize(negativeZeroOne) == 0 && read == fraction);
+    const uint8_t half[] = {2, 1, 0, 0, 0, 2, 2, 0, 0, 0};
+    const uint8_t zero[] = {0, 2, 1, 0, 0, 0};
+    assert(read.deserialize(half) == 10 && read == Rational(1, 2));
+    assert(read.deserialize(zero) == 6 && read == Rational(0));
+    assert(read.hash() == Rational(0).hash());
+}
+
+void test24() {
+    std::istringstream in("  -00123abc +0 - 42 -0 12345678901234567890123");
+    BigInteger value = 5;
+    in >> value;
+    assert(value == -123 && in.good());
+    std::string word;
+    in >> word;
+    assert(word == "abc");
+    in >> value;
+    assert(value == 0);
+    in >> value;
+    assert(in.fail() && value == 0);
+    in.clear();
+    in >> word >> value;
+    assert(word == "42" && value == 0 && !value.getNegative());
+    in >> value;
+    assert(value == "12345678901234567890123"_bi && in.eof());
+
+    std::string digits(2000, '9');
+    std::istringstream large(digits);
+    large >> value;
+    assert(value == pow(10_bi, 2000) - 1);
+
+    // Past one block of text the digits are parsed in pieces and merged.
+    for (size_t size : {9216, 9217, 5 * 9216 + 123}) {
+        std::string text = "-";
+        for (size_t i = 0; i < size; ++i) {
+            text += static_cast<char>('1' + i * 7 % 9);
+        }
+        std::istringstream blocks(text + " 7");
+        blocks >> value;
+        assert(value == BigInteger(text) && value.toString() == text);
+        blocks >> value;
+        assert(value == 7);
+    }
+}
+
+void test25() {
+    BigInteger value = "-340282366920938463463374607431768211455"_bi;
+    BigInteger expected = (BigInteger(1) << 256) - (BigInteger(1) << 129) + 1;
+    BigInteger copy = value;
+    assert(copy.square() == expected);
+    assert(value * value == expected);
+
+    BigInteger large = pow(7_bi, 5000) - 1;
+    BigInteger other = large + 1;
+    BigInteger squared = large;
+    squared.square();
+    assert(squared == large * other - large);
+    assert(pow(-3_bi, 5) == -243);
+    assert(pow(0_bi, 0) == 1);
+}
+
+void test26() {
+    std::hash<BigInteger> hashInteger;
+    BigInteger zero = BigInteger(-5) + 5;
+    assert(hashInteger(zero) == hashInteger(BigInteger(0)));
+    assert(hashInteger(-zero) == hashInteger(BigInteger(0)));
+    BigInteger large = pow(3_bi, 500);
+    assert(hashInteger(large) == hashInteger(large * 2 - large));
+    assert(hashInteger(large) != hashInteger(-large));
+    assert(hashInteger(large) != hashInteger(large + 1));
+
+    std::hash<Rational> hashRational;
+    assert(hashRational(Rational(2, 4)) == hashRational(Rational(1, 2)));
+    assert(hashRational(Rational(-2, 4)) == hashRational(Rational(1, -2)));
+    assert(hashRational(Rational(1, 2)) != hashRational(Rational(-1, 2)));
+    assert(hashRational(Rational(1, 2)) != hashRational(Rational(2, 1)));
+    assert(hashRational(Rational(3)) == hashRational(Rational(6, 2)));
+
+    std::unordered_map<BigInteger, int> counts;
+    for (int i = 0; i < 1000; ++i) {
+        ++counts[BigInteger(i % 100) * large];
+    }
+    assert(counts.size() == 100);
+    assert(counts[large * 7] == 10);
+}
+
+void test27() {
+    BigIntegerMatrix small = {{2, -3, 1}, {2, 0, -1}, {1, 4, 5}};
+    assert(small.determinant() == 49);
+    assert(small.modularDeterminant() == 49);
+    assert(small.rank() == 3);
+    BigIntegerMatrix swapped = {{0, 1}, {1, 0}};
+    assert(swapped.determinant() == -1);
+    assert(swapped.modularDeterminant() == -1);
+    BigIntegerMatrix singular = {{1, 2, 3}, {2, 4, 6}, {1, 0, 1}};
+    assert(singular.determinant() == 0);
+    assert(singular.modularDeterminant() == 0);
+    assert(singular.rank() == 2);
+    assert(!singular.solve(std::vector<BigInteger>{1, 2, 3}).has_value());
+    for (bool longFirst : {true, false}) {
+        bool thrown = false;
+        try {
+            BigIntegerMatrix ragged =
+                longFirst ? BigIntegerMatrix{{1, 2}, {3}}
+                          : BigIntegerMatrix{{1}, {2, 3}};
+            static_cast<void>(ragged);
+        } catch (const std::invalid_argument&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+    BigIntegerMatrix wide = {{0, 0, 1, 2}, {0, 0, 2, 4}, {0, 1, 0, 0}};
+    assert(wide.rank() == 2);
+
+    std::vector<BigInteger> rhs = {1, -2, 3};
+    std::vector<Rational> x = *small.solve(rhs);
+    for (size_t i = 0; i < 3; ++i) {
+        Rational sum;
+        for (size_t j = 0; j < 3; ++j) {
+            sum += Rational(small(i, j)) * x[j];
+        }
+        assert(sum == Rational(rhs[i]));
+    }
+
+    // A Vandermonde matrix: det = prod over i < j of (x_j - x_i).
+    setMultiplicationThreads(4);
+    const size_t n = 40;
+    BigIntegerMatrix vandermonde(n, n);
+    BigInteger expected = 1;
+    for (size_t i = 0; i < n; ++i) {
+        BigInteger power = 1;
+        for (size_t j = 0; j < n; ++j) {
+            vandermonde(i, j) = power;
+            power *= static_cast<long long>(i * i + 1);
+        }
+        for (size_t k = 0; k < i; ++k) {
+            expected *= static_cast<long long>(i * i - k * k);
+        }
+    }
+    assert(vandermonde.determinant() == expected);
+    assert(vandermonde.modularDeterminant() == expected);
+    assert(vandermonde.rank() == n);
+    std::swap_ranges(&vandermonde(0, 0), &vandermonde(0, 0) + n,
+                     &vandermonde(1, 0));
+    assert(vandermonde.determinant() == -expected);
+    assert(vandermonde.modularDeterminant() == -expected);
+    setMultiplicationThreads(0);
+
+    // The Hilbert matrix times the all-ones vector.
+    const size_t size = 8;
+    std::vector<std::vector<Rational>> hilbert(size);
+    std::vector<Rational> sums(size);
+    for (size_t i = 0; i < size; ++i) {
+        for (size_t j = 0; j < size; ++j) {
+            hilbert[i].emplace_back(1, static_cast<long long>(i + j + 1));
+            sums[i] += hilbert[i][j];
+        }
+    }
+    std::vector<Rational> ones = *solve(hilbert, sums);
+    assert(ones == std::vector<Rational>(size, Rational(1)));
+    hilbert[0][0] = -hilbert[0][0];
+    sums[0] -= 2;
+    std::vector<Rational> flipped = *solve(hilbert, sums);
+    assert(flipped == std::vector<Rational>(size, Rational(1)));
+}
+
+void test28() {
+    const long long kMax = std::numeric_limits<long long>::max();
+    const long long kMin = std::numeric_limits<long long>::min();
+    BigInteger max = kMax;
+    assert(Rational(kMax) + 1 == Rational(max + 1));
+    assert(Rational(kMin) + 1 == Rational(kMin + 1));
+    assert(Rational(kMin) - 1 == Rational(BigInteger(kMin) - 1));
+    assert(Rational(1, kMax) + Rational(1, kMax - 1) ==
+           Rational(2 * max - 1, max * (max - 1)));
+    assert(Rational(kMax) * Rational(kMax) == Rational(max * max));
+    assert(Rational(kMax, 3) / Rational(2, kMax) ==
+           Rational(max * max, BigInteger(6)));
+    assert(Rational(kMax, kMax - 1) < Rational(kMax - 1, kMax - 2));
+    assert(Rational(-kMax, kMax - 1) > Rational(1 - kMax, kMax - 2));
+    assert(Rational(-1, 2) < Rational(0));
+    assert(!(Rational(0) < Rational(0)));
+    assert(Rational(6, -4) == Rational(-3, 2));
+    assert(Rational(0, -7) == Rational(0));
+
+    Rational harmonic;
+    for (long long i = 1; i <= 60; ++i) {
+        harmonic += Rational(1, i);
+    }
+    BigInteger numerator;
+    BigInteger denominator = 1;
+    for (long long i = 1; i <= 60; ++i) {
+        numerator = numerator * i + denominator;
+        denominator *= i;
+    }
+    assert(harmonic == Rational(numerator, denominator));
+}
+
+void test29() {
+    assert(!isProbablePrime(-7) && !isProbablePrime(0) && !isProbablePrime(1));
+    assert(isProbablePrime(2) && isProbablePrime(4294967291));
+    assert(!isProbablePrime(4294967297));
+    // Strong pseudoprimes to base 2 (the last to every base up to 37),
+    // left to the Lucas test.
+    assert(!isProbablePrime(BigInteger("18446744073709551617")));
+    assert(!isProbablePrime(BigInteger("3825123056546413051")));
+    assert(!isProbablePrime(BigInteger("318665857834031151167461")));
+    BigInteger mersenne = (BigInteger(1) << 521) - 1;
+    assert(isProbablePrime(mersenne));
+    assert(!isProbablePrime(mersenne * mersenne));
+    assert(!isProbablePrime((BigInteger(1) << 523) - 1));
+
+    std::vector<BigInteger> candidates;
+    for (long long i = 0; i < 200; ++i) {
+        candidates.push_back((BigInteger(1) << 127) + i);
+    }
+    setMultiplicationThreads(4);
+    std::vector<bool> batch = isProbablePrime(candidates);
+    setMultiplicationThreads(0);
+    std::vector<BigInteger> window =
+        primesInRange(BigInteger(1) << 127, candidates.size());
+    size_t found = 0;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        assert(batch[i] == isProbablePrime(candidates[i]));
+        if (batch[i]) {
+            assert(window[found++] == candidates[i]);
+        }
+    }
+    assert(found == window.size() && found > 0);
+
+    std::vector<BigInteger> small = primesInRange(-10, 110);
+    assert(small.size() == 25 && small.front() == 2 && small.back() == 97);
+    std::vector<BigInteger> segments = primesInRange(1000000, 100000);
+    assert(segments.size() == 7216);
+    assert(segments.front() == 1000003 && segments.back() == 1099997);
+    assert(primesInRange(24, 5).empty() && primesInRange(-5, 6).empty());
+}
+
+void test30() {
+    // Ties go to the even neighbour, everything else to the nearest.
+    assert(BigFloat().getPrecision() == BigFloat::kDefaultPrecision);
+    assert(BigFloat(BigInteger(1) << 100).getPrecision() == 101);
+    assert(BigFloat(BigInteger(9), 3) == BigFloat(8));
+    assert(BigFloat(BigInteger(11), 3) == BigFloat(12));
+    assert(BigFloat(BigInteger(-13), 3) == BigFloat(-12));
+    BigFloat tenth("0.1", 53);
+    assert(tenth.getMantissa() == 3602879701896397);
+    assert(tenth.getExponent() == -55);
+    assert(BigFloat(Rational(1, 10), 53) == tenth);
+    assert(BigFloat("-2.5e3", 20) == BigFloat(-2500));
+    std::string text = "1.5";
+    assert(BigFloat(text, 8) == BigFloat(std::string_view(text), 8));
+    assert(BigFloat(std::string("1.5E+2"), 8) == BigFloat(150));
+    // A power of ten past unsigned throws instead of wrapping to 10^0.
+    for (const char* huge : {"1e4294967296", "1e-4294967296",
+                             "1e99999999999999999999", "0.1e4294967297"}) {
+        bool thrown = false;
+        try {
+            static_cast<void>(BigFloat(huge, 64));
+        } catch (const std::out_of_range&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+    for (const char* malformed :
+         {"", "-", ".", "e5", "1e", "2.5E", "1e+", "1e5x", "1.2.3", "1_0"}) {
+        bool thrown = false;
+        try {
+            static_cast<void>(BigFloat(malformed, 64));
+        } catch (const std::invalid_argument&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+    assert(BigFloat("5.", 8) == 5 && BigFloat(".5", 8) == BigFloat("0.5", 8));
+    // Huge powers of ten are bracketed, never built: 10^(10^9) is about
+    // 2^3321928094.887362, and 10^(10^9) / 2^3321928094 = 1.8563...
+    BigFloat huge("1e1000000000", 64);
+    assert(huge.getMantissa().bitLength() +
+               static_cast<size_t>(huge.getExponent()) ==
+           3321928095);
+    assert(BigFloat("-1e1000000000", 64) == -huge);
+    BigFloat product = huge * BigFloat("1e-1000000000", 64);
+    assert(BigFloat("0.999999999999", 64) < product);
+    assert(product < BigFloat("1.000000000001", 64));
+    assert(BigFloat("0e4000000000", 64) == BigFloat());
+    assert(BigFloat("1.5e20", 70) == BigFloat("150000000000000000000", 70));
+    assert(BigFloat("1.5e20", 70).toRational() == 150 * pow(10_bi, 18));
+
+    BigFloat two(BigInteger(2), 200);
+    BigFloat root = sqrt(two);
+    assert(root.getPrecision() == 200);
+    assert(root.asDecimal(50) ==
+           "1.41421356237309504880168872420969807856967187537694");
+    BigFloat one(BigInteger(1), 200);
+    assert((one / 3).asDecimal(20) == "0.33333333333333333333");
+    assert((-one / 3).asDecimal(3) == "-0.333");
+    assert((one / 4).toRational() == Rational(1, 4));
+
+    // Far apart operands: the small one only decides the rounding.
+    BigFloat tiny("1e-5000", 64);
+    BigFloat big(BigInteger(1) << 63, 64);
+    assert(big + tiny == big && big - tiny == big);
+    assert(big + BigFloat("0.5", 64) == big);
+    assert(big + BigFloat("1.5", 64) == big + 2);
+    BigFloat wide(BigInteger(1), 17000);
+    assert((wide + tiny) - wide == tiny && wide - tiny < wide);
+
+    assert(BigFloat(3) < BigFloat(5) && BigFloat(-5) < BigFloat(-3));
+    assert(BigFloat(-1) < BigFloat() && BigFloat() < tiny);
+    assert(BigFloat(7) * BigFloat(6) == BigFloat(42) && BigFloat(6) <= 6);
+    assert(sqrt(BigFloat(-4)) == BigFloat());
+
+    // The logistic map stays at 256 bits where a Rational would double.
+    BigFloat x("0.3", 256);
+    for (int i = 0; i < 1000; ++i) {
+        x = 4 * x * (1 - x);
+    }
+    assert(x.getPrecision() == 256 && x.getMantissa().bitLength() <= 256);
+    assert(BigFloat() <= x && x <= 1);
+}
+
+size_t& limbAllocations() {
+    static size_t count = 0;
+    return count;
+}
+
+void test31() {
+    LimbAllocator previous = setLimbAllocator(
+        {[](size_t size) {
+             ++limbAllocations();
+             return new uint32_t[size];
+         },
+         [](uint32_t* limbs, size_t /*size*/) { delete[] limbs; }});
+    BigInteger a = pow(BigInteger(3), 200'000) + 12345;
+    BigInteger b = pow(BigInteger(7), 40'000) - 1;
+    BigInteger c = (BigInteger(1) << 96'000) + 777;
+    BigInteger q, r;
+    for (int round = 0; round < 2; ++round) {
+        // Per division: the dividend copied into the operator, the quotient
+        // and the remainder; all scratch comes from the per-thread arena.
+        limbAllocations() = 0;
+        q = a / b;
+        r = a % c;
+        assert(limbAllocations() <= 6);
+        limbAllocations() = 0;
+        BigInteger p = a * b;
+        assert(limbAllocations() <= 2);
+        limbAllocations() = 0;
+        BigInteger g = greatestCommonDivisor(b, c);
+        assert(limbAllocations() <= 8);
+    }
+    assert(q * b + a % b == a && r < c && (a - r) % c == 0);
+    assert(setLimbAllocator(previous).allocate != previous.allocate);
+}
+
+void test32() {
+    // Threads sharing the pool, with a threshold low enough that pool tasks
+    // fork and wait on nested groups of their own.
+    BigInteger first = pow(3_bi, 20'000);
+    BigInteger second = pow(7_bi, 12'000) + 1;
+    setMultiplicationThreads(1);
+    BigInteger expected = first * second;
+    expected *= expected;
+    setMultiplicationThreads(4);
+    setParallelMultiplicationThreshold(40);
+    std::atomic<int> failures = 0;
+    std::vector<std::thread> callers;
+    for (int i = 0; i < 3; ++i) {
+        callers.emplace_back([&] {
+            for (int round = 0; round < 3; ++round) {
+                BigInteger product = first * second;
+                product *= product;
+                if (product != expected) {
+                    ++failures;
+                }
+            }
+        });
+    }
+    for (std::thread& caller : callers) {
+        caller.join();
+    }
+    assert(failures == 0);
+    setMultiplicationThreads(0);
+    setParallelMultiplicationThreshold(1024);
+}
+
+void test33() {
+    // Bareiss row updates run as pool tasks whose products are themselves
+    // split across the pool.
+    const size_t n = 24;
+    BigIntegerMatrix matrix(n, n);
+    BigInteger state = 1;
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            state = (state * 6'364'136'223'846'793'005LL + 1) % (1_bi << 64);
+            matrix(i, j) = (1_bi << 1279) + state * state;
+        }
+    }
+    setMultiplicationThreads(1);
+    BigInteger serial = matrix.determinant();
+    setMultiplicationThreads(4);
+    setParallelMultiplicationThreshold(40);
+    assert(matrix.determinant() == serial);
+    assert(matrix.modularDeterminant() == serial);
+    setMultiplicationThreads(0);
+    setParallelMultiplicationThreshold(1024);
+}
+
+void test34() {
+    // Batch primality with the Lucas products themselves split across the
+    // pool that runs the candidates.
+    std::vector<BigInteger> candidates =
+        primesInRange(BigInteger(1) << 1000, 8000);
+    assert(candidates.size() > 4);
+    candidates.push_back(candidates[0] * candidates[1]);
+    candidates.push_back(candidates[0] + 2);
+    std::vector<bool> serial;
+    for (const BigInteger& candidate : candidates) {
+        serial.push_back(isProbablePrime(candidate));
+    }
+    setMultiplicationThreads(4);
+    setParallelMultiplicationThreshold(40);
+    assert(isProbablePrime(candidates) == serial);
+    setMultiplicationThreads(0);
+    setParallelMultiplicationThreshold(1024);
+    assert(!serial[serial.size() - 2] && !serial.back());
+}
+
+int main() {
+    test1();
+    std::cerr << "Test 1 passed." << std::endl;
+    test2();
+    std::cerr << "Test 2 passed." << std::endl;
+    test3();
+    std::cerr << "Test 3 passed." << std::endl;
+    test4();
+    std::cerr << "Test 4 passed." << std::endl;
+    test5();
+    std::cerr << "Test 5 passed." << std::endl;
+    test6();
+    std::cerr << "Test 6 passed." << std::endl;
+    test7();
+    std::cerr << "Test 7 passed." << std::endl;
+    test8();
+    std::cerr << "Test 8 passed." << std::endl;
+    test9();
+    std::cerr << "Test 9 passed." << std::endl;
+    test10();
+    std::cerr << "Test 10 passed." << std::endl;
+    test11();
+    std::cerr << "Test 11 passed." << std::endl;
+    test12();
+    std::cerr << "Test 12 passed." << std::endl;
+    test13();
+    std::cerr << "Test 13 passed." << std::endl;
+    test14();
+    std::cerr << "Test 14 passed." << std::endl;
+    test15();
+    std::cerr << "Test 15 passed." << std::endl;
+    test16();
+    std::cerr << "Test 16 passed." << std::endl;
+    test17();
+    std::cerr << "Test 17 passed." << std::endl;
+    test18();
+    std::cerr << "Test 18 passed." << std::endl;
+    test19();
+    std::cerr << "Test 19 passed." << std::endl;
+    test20();
+    std::cerr << "Test 20 passed." << std::endl;
+    test21();
+    std::cerr << "Test 21 passed." << std::endl;
+    test22();
+    std::cerr << "Test 22 passed." << std::endl;
+    test23();
+    std::cerr << "Test 23 passed." << std::endl;
+    test24();
+    std::cerr << "Test 24 passed." << std::endl;
+    test25();
+    std::cerr << "Test 25 passed." << std::endl;
+    test26();
+    std::cerr << "Test 26 passed." << std::endl;
+    test27();
+    std::cerr << "Test 27 passed." << std::endl;
+    test28();
+    std::cerr << "Test 28 passed." << std::endl;
+    test29();
+    std::cerr << "Test 29 passed." << std::endl;
+    test30();
+    std::cerr << "Test 30 passed." << std::endl;
+    test31();
+    std::cerr << "Test 31 passed." << std::endl;
+    test32();
+    std::cerr << "Test 32 passed." << std::endl;
+    test33();
+    std::cerr << "Test 33 passed." << std::endl;
+    test34();
+    std::cerr << "Test 34 passed." << std::endl;
+}